@@ -8,6 +8,7 @@ let lastHeartbeatResponse = Date.now();
 const HEARTBEAT_TIMEOUT = 20000;
 let reconnectTimer = null;
 let spoolDetected = false;
+let spoolInfoCache = {}; // Spoolman-Daten je sm_id, vom Server vorab geladen
 
 // WebSocket Funktionen
 function startHeartbeat() {
@@ -104,6 +105,11 @@ function initWebSocket() {
                 updateNfcData(data.payload);
             } else if (data.type === 'writeNfcTag') {
                 handleWriteNfcTagResponse(data.success);
+            } else if (data.type === 'writeNfcBatch') {
+                handleWriteNfcBatchResponse(data);
+            } else if (data.type === 'spoolInfo') {
+                spoolInfoCache[data.sm_id] = data.payload;
+                showSpoolInfo();
             } else if (data.type === 'heartbeat') {
                 // Optional: Spezifische Behandlung von Heartbeat-Antworten
                 // Update status dots
@@ -563,7 +569,7 @@ function updateNfcData(data) {
 
     if(data.sm_id){
         html = `
-        <div class="nfc-card-data" style="margin-top: 10px;">
+        <div class="nfc-card-data" data-sm-id="${data.sm_id}" style="margin-top: 10px;">
             <p><strong>Brand:</strong> ${data.brand || 'N/A'}</p>
             <p><strong>Type:</strong> ${data.type || 'N/A'} ${data.color_hex ? `<span style="
                 background-color: #${data.color_hex}; 
@@ -619,6 +625,50 @@ function updateNfcData(data) {
     
     // Neues div zum Container hinzufügen
     nfcStatusContainer.appendChild(nfcDataDiv);
+    showSpoolInfo();
+}
+
+// Ergänzt die Tag-Daten um die vom Server vorab geladenen Spoolman-Daten
+function showSpoolInfo() {
+    const card = document.querySelector('.nfc-card-data[data-sm-id]');
+    if (!card || card.querySelector('.spool-info')) return;
+
+    const info = spoolInfoCache[card.dataset.smId];
+    if (!info) return;
+
+    const infoDiv = document.createElement('div');
+    infoDiv.className = 'spool-info';
+    let html = '';
+    if (info.nozzle_temp_min && info.nozzle_temp_max) {
+        html += `<p><strong>Nozzle:</strong> ${info.nozzle_temp_min}-${info.nozzle_temp_max}°C</p>`;
+    }
+    if (info.tray_info_idx && info.tray_info_idx !== 'null') {
+        html += `<p><strong>Bambu Profile:</strong> ${info.tray_info_idx}</p>`;
+    }
+    infoDiv.innerHTML = html;
+    card.appendChild(infoDiv);
+}
+
+function buildSpoolNfcData(spool) {
+    // Temperaturwerte korrekt extrahieren
+    let minTemp = "175";
+    let maxTemp = "275";
+    
+    if (Array.isArray(spool.filament.nozzle_temperature) && 
+        spool.filament.nozzle_temperature.length >= 2) {
+        minTemp = String(spool.filament.nozzle_temperature[0]);
+        maxTemp = String(spool.filament.nozzle_temperature[1]);
+    }
+
+    // Erstelle das NFC-Datenpaket mit korrekten Datentypen
+    return {
+        color_hex: spool.filament.color_hex || "FFFFFF",
+        type: spool.filament.material,
+        min_temp: minTemp,
+        max_temp: maxTemp,
+        brand: spool.filament.vendor.name,
+        sm_id: String(spool.id) // Konvertiere zu String
+    };
 }
 
 function writeNfcTag() {
@@ -639,25 +689,7 @@ function writeNfcTag() {
             return;
         }
 
-        // Temperaturwerte korrekt extrahieren
-        let minTemp = "175";
-        let maxTemp = "275";
-        
-        if (Array.isArray(selectedSpool.filament.nozzle_temperature) && 
-            selectedSpool.filament.nozzle_temperature.length >= 2) {
-            minTemp = String(selectedSpool.filament.nozzle_temperature[0]);
-            maxTemp = String(selectedSpool.filament.nozzle_temperature[1]);
-        }
-
-        // Erstelle das NFC-Datenpaket mit korrekten Datentypen
-        const nfcData = {
-            color_hex: selectedSpool.filament.color_hex || "FFFFFF",
-            type: selectedSpool.filament.material,
-            min_temp: minTemp,
-            max_temp: maxTemp,
-            brand: selectedSpool.filament.vendor.name,
-            sm_id: String(selectedSpool.id) // Konvertiere zu String
-        };
+        const nfcData = buildSpoolNfcData(selectedSpool);
 
         if (socket?.readyState === WebSocket.OPEN) {
             const writeButton = document.getElementById("writeNfcButton");
@@ -702,6 +734,72 @@ function writeLocationNfcTag() {
     }
 }
 
+// Writes all spools of the selected manufacturer without tag, one tag after another
+function writeNfcBatch() {
+    const batchButton = document.getElementById("writeNfcBatchButton");
+
+    if (socket?.readyState !== WebSocket.OPEN) {
+        alert('Not connected to Server. Please check connection.');
+        return;
+    }
+
+    // Zweiter Klick bricht den laufenden Batch ab
+    if (batchButton.classList.contains("writing")) {
+        socket.send(JSON.stringify({
+            type: 'writeNfcBatch',
+            action: 'cancel'
+        }));
+        return;
+    }
+
+    const vendorId = document.getElementById("vendorSelect").value;
+    const spools = window.getSpoolData().filter(spool => {
+        const hasValidNfcId = spool.extra && 
+                              spool.extra.nfc_id && 
+                              spool.extra.nfc_id !== '""' && 
+                              spool.extra.nfc_id !== '"\\"\\"\\""';
+        return spool.filament.vendor.id == vendorId && !hasValidNfcId;
+    });
+
+    if (spools.length === 0) {
+        alert('No spools without tag for this manufacturer.');
+        return;
+    }
+
+    if (!confirm(`Write ${spools.length} tags? Place one new tag after another on the reader.`)) {
+        return;
+    }
+
+    batchButton.classList.add("writing");
+    batchButton.textContent = `Tag 0/${spools.length} - Cancel`;
+    socket.send(JSON.stringify({
+        type: 'writeNfcBatch',
+        tagType: 'spool',
+        payloads: spools.map(buildSpoolNfcData)
+    }));
+}
+
+function handleWriteNfcBatchResponse(data) {
+    const batchButton = document.getElementById("writeNfcBatchButton");
+
+    if (data.state === 'progress') {
+        batchButton.textContent = `Tag ${data.written}/${data.total} - Cancel`;
+        if (!data.success) {
+            showNotification('Write failed - place the tag again', false);
+        }
+        return;
+    }
+
+    batchButton.classList.remove("writing");
+    batchButton.textContent = "Write all Tags";
+
+    if (data.state === 'rejected') {
+        showNotification(`Batch not started (max. ${data.max} spools)`, false);
+    } else {
+        showNotification(`${data.written} of ${data.total} tags written`, data.state === 'done');
+    }
+}
+
 function handleWriteNfcTagResponse(success) {
     const writeButton = document.getElementById("writeNfcButton");
     const writeLocationButton = document.getElementById("writeLocationNfcButton");
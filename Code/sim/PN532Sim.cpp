@@ -0,0 +1,413 @@
+#include <Arduino.h>
+#include <string.h>
+#include "PN532Sim.h"
+#include "Adafruit_PN532.h"
+#include "Wire.h"
+
+#define NTAG_CMD_READ               0x30
+#define NTAG_CMD_FAST_READ          0x3A
+#define NTAG_CMD_GET_VERSION        0x60
+#define NTAG_CMD_WRITE              0xA2
+
+#define PN532_FIRMWARE_VERSION      0x32010607UL    // PN532 v1.6
+
+PN532Sim pn532SimChannels[SIM_MUX_CHANNELS];
+PN532Sim& pn532Sim = pn532SimChannels[0];
+uint32_t simMuxSelects = 0;
+static uint8_t simMuxChannel = 0;
+
+PN532Sim& simSelectedReader() {
+    return pn532SimChannels[simMuxChannel];
+}
+
+PN532Sim& simReaderForIrq(uint8_t pin) {
+    for (uint8_t i = 0; i < SIM_MUX_CHANNELS; i++) {
+        if (pn532SimChannels[i].irqPin == pin) return pn532SimChannels[i];
+    }
+    return pn532Sim;
+}
+
+struct SimTagModel {
+    uint8_t totalPages;
+    uint8_t storageSize;    // GET_VERSION byte 6
+    uint8_t ccSize;         // CC byte 2, data area / 8
+};
+
+static const SimTagModel SIM_TAG_MODELS[] = {
+    {  45, 0x0F, 0x12 },    // NTAG213
+    { 135, 0x11, 0x3E },    // NTAG215
+    { 231, 0x13, 0x6D },    // NTAG216
+};
+
+PN532Sim::PN532Sim() {
+    // I2C at 100 kHz, NTAG21x datasheet values for the air interface
+    setLink(SIM_LINK_I2C, 100000);
+    irqPin = SIM_IRQ_UNWIRED;
+    timing.pn532Processing = 300;
+    timing.rfByte = 85;
+    timing.activation = 5000;
+    timing.tagWrite = 4100;
+
+    model = SIM_NTAG213;
+    memset(memory, 0, sizeof(memory));
+    memset(locked, 0, sizeof(locked));
+    memset(uid, 0, sizeof(uid));
+    readFailPage = 0;
+    readFailCount = 0;
+    writeFailPage = 0;
+    writeFailCount = 0;
+    present = false;
+    selected = false;
+    listening = false;
+    removeCountdown = 0;
+    returnDelayMs = 0;
+    returnAt = 0;
+    resetCounters();
+}
+
+void PN532Sim::placeTag(simTagModelType tagModel, const uint8_t* tagUid) {
+    model = tagModel;
+    memcpy(uid, tagUid, sizeof(uid));
+    memset(memory, 0, sizeof(memory));
+    memset(locked, 0, sizeof(locked));
+
+    // UID with check bytes as in the NTAG21x memory map
+    memory[0][0] = uid[0];
+    memory[0][1] = uid[1];
+    memory[0][2] = uid[2];
+    memory[0][3] = 0x88 ^ uid[0] ^ uid[1] ^ uid[2];
+    memcpy(memory[1], &uid[3], 4);
+    memory[2][0] = uid[3] ^ uid[4] ^ uid[5] ^ uid[6];
+    memory[2][1] = 0x48;
+
+    // Capability container of a factory formatted tag with an empty NDEF message
+    memory[3][0] = 0xE1;
+    memory[3][1] = 0x10;
+    memory[3][2] = SIM_TAG_MODELS[model].ccSize;
+    memory[4][0] = 0x03;
+    memory[4][2] = 0xFE;
+
+    readFailCount = 0;
+    writeFailCount = 0;
+    present = true;
+    selected = false;
+    removeCountdown = 0;
+    returnAt = 0;
+}
+
+void PN532Sim::removeTag() {
+    present = false;
+    selected = false;
+    returnAt = 0;
+}
+
+void PN532Sim::removeTagAfter(uint32_t tagCommands, uint32_t returnAfterMs) {
+    removeCountdown = tagCommands + 1;
+    returnDelayMs = returnAfterMs;
+}
+
+uint8_t PN532Sim::lastUserPage() const {
+    return SIM_TAG_MODELS[model].totalPages - 6;
+}
+
+bool PN532Sim::loadUserData(const uint8_t* data, size_t length) {
+    if (length > (size_t)(lastUserPage() - 3) * 4) return false;
+    memcpy(memory[4], data, length);
+    return true;
+}
+
+void PN532Sim::lockPage(uint8_t lockedPage) {
+    if (lockedPage >= SIM_TAG_MODELS[model].totalPages) return;
+    locked[lockedPage] = true;
+
+    if (lockedPage >= 3 && lockedPage <= 7) memory[2][2] |= 1 << lockedPage;
+    else if (lockedPage >= 8 && lockedPage <= 15) memory[2][3] |= 1 << (lockedPage - 8);
+}
+
+void PN532Sim::failReads(uint8_t failPage, uint8_t count) {
+    readFailPage = failPage;
+    readFailCount = count;
+}
+
+void PN532Sim::failWrites(uint8_t failPage, uint8_t count) {
+    writeFailPage = failPage;
+    writeFailCount = count;
+}
+
+void PN532Sim::setLink(simLinkType link, uint32_t clockHz) {
+    // Bits per byte: I2C 8 + ACK, SPI 8, UART start + 8 + stop
+    uint32_t bitsPerByte = link == SIM_LINK_I2C ? 9 : (link == SIM_LINK_SPI ? 8 : 10);
+    timing.busByte = (bitsPerByte * 1000000UL + clockHz / 2) / clockHz;
+    timing.frameOverhead = SIM_PN532_READY_MICROS + SIM_PN532_FRAMING_BYTES * timing.busByte;
+}
+
+void PN532Sim::resetCounters() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Host side of one PN532 command: request frame, ACK frame and response frame
+uint32_t PN532Sim::command(size_t sendBytes, size_t receiveBytes) {
+    stats.transactions++;
+    stats.frames += 3;
+    stats.busBytes += sendBytes + receiveBytes + SIM_PN532_FRAMING_BYTES;
+
+    uint32_t micros = timing.frameOverhead + timing.pn532Processing + (sendBytes + receiveBytes) * timing.busByte;
+    stats.busMicros += micros;
+    simAdvanceMicros(micros);
+    return micros;
+}
+
+// Air interface time of a tag command, both directions carry a CRC
+bool PN532Sim::tagTransaction(size_t sendBytes, size_t receiveBytes) {
+    if (removeCountdown > 0 && --removeCountdown == 0) {
+        removeTag();
+        if (returnDelayMs > 0) returnAt = simMicros() + (uint64_t)returnDelayMs * 1000;
+    }
+    if (!present || !selected) {
+        stats.failures++;
+        return false;
+    }
+
+    stats.tagCommands++;
+    uint32_t micros = (sendBytes + receiveBytes + 4) * timing.rfByte;
+    stats.busMicros += micros;
+    simAdvanceMicros(micros);
+    return true;
+}
+
+// A NAK puts the tag back into IDLE state, it has to be selected again
+bool PN532Sim::nak() {
+    stats.failures++;
+    selected = false;
+    return false;
+}
+
+bool PN532Sim::readFails(uint8_t first, uint8_t last) {
+    if (readFailCount == 0 || readFailPage < first || readFailPage > last) return false;
+    readFailCount--;
+    return true;
+}
+
+bool PN532Sim::activate(uint8_t* tagUid, uint8_t* uidLength, uint16_t timeout) {
+    listening = false;
+    if (!present && returnAt > 0 && simMicros() >= returnAt) {
+        present = true;
+        returnAt = 0;
+    }
+    command(3, present ? 15 : 0);
+
+    if (!present) {
+        stats.failures++;
+        simAdvanceMicros((uint64_t)timeout * 1000);
+        return false;
+    }
+
+    stats.busMicros += timing.activation;
+    simAdvanceMicros(timing.activation);
+    memcpy(tagUid, uid, sizeof(uid));
+    *uidLength = sizeof(uid);
+    selected = true;
+    return true;
+}
+
+bool PN532Sim::exchange(const uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength) {
+    uint8_t totalPages = SIM_TAG_MODELS[model].totalPages;
+    uint8_t data[SIM_NTAG_MAX_PAGES * 4];
+    size_t dataLength = 0;
+
+    listening = false;
+    if (sendLength == 0) return false;
+
+    switch (send[0]) {
+        case NTAG_CMD_READ: {
+            // 4 pages, rolls over at the end of the memory
+            command(sendLength + 1, 17);
+            if (sendLength < 2 || !tagTransaction(2, 16)) return false;
+            if (send[1] >= totalPages || readFails(send[1], send[1] + 3)) return nak();
+            for (uint8_t i = 0; i < 4; i++) {
+                memcpy(&data[i * 4], memory[(send[1] + i) % totalPages], 4);
+            }
+            dataLength = 16;
+            stats.pagesRead += 4;
+            break;
+        }
+        case NTAG_CMD_FAST_READ: {
+            if (sendLength < 3 || send[2] < send[1]) return nak();
+            size_t pages = send[2] - send[1] + 1;
+            command(sendLength + 1, pages * 4 + 1);
+            if (!tagTransaction(3, pages * 4)) return false;
+            if (send[2] >= totalPages || readFails(send[1], send[2])) return nak();
+            memcpy(data, memory[send[1]], pages * 4);
+            dataLength = pages * 4;
+            stats.pagesRead += pages;
+            break;
+        }
+        case NTAG_CMD_GET_VERSION: {
+            command(sendLength + 1, 9);
+            if (!tagTransaction(1, 8)) return false;
+            const uint8_t version[8] = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, SIM_TAG_MODELS[model].storageSize, 0x03 };
+            memcpy(data, version, sizeof(version));
+            dataLength = sizeof(version);
+            break;
+        }
+        case NTAG_CMD_WRITE: {
+            command(sendLength + 1, 1);
+            if (sendLength < 6 || !tagTransaction(6, 1)) return false;
+
+            uint8_t writePage = send[1];
+            if (writeFailCount > 0 && writeFailPage == writePage) {
+                writeFailCount--;
+                return nak();
+            }
+            if (writePage < 2 || writePage >= totalPages || locked[writePage]) return nak();
+
+            stats.busMicros += timing.tagWrite;
+            simAdvanceMicros(timing.tagWrite);
+            stats.pagesWritten++;
+
+            if (writePage == 2) {
+                // Only the lock bytes are writable and bits can only be set
+                memory[2][2] |= send[4];
+                memory[2][3] |= send[5];
+                for (uint8_t p = 3; p <= 15; p++) {
+                    if (p <= 7 ? (memory[2][2] >> p) & 1 : (memory[2][3] >> (p - 8)) & 1) locked[p] = true;
+                }
+            } else if (writePage == 3) {
+                // Capability container is OTP
+                for (uint8_t i = 0; i < 4; i++) memory[3][i] |= send[2 + i];
+            } else {
+                memcpy(memory[writePage], &send[2], 4);
+            }
+            *responseLength = 0;
+            return true;
+        }
+        default:
+            command(sendLength + 1, 1);
+            if (!tagTransaction(sendLength, 0)) return false;
+            return nak();
+    }
+
+    // Longer responses do not fit the driver's packet buffer
+    if (dataLength > SIM_PN532_MAX_DATA) {
+        stats.failures++;
+        return false;
+    }
+
+    if (dataLength > *responseLength) dataLength = *responseLength;
+    memcpy(response, data, dataLength);
+    *responseLength = dataLength;
+    return true;
+}
+
+// ##### Adafruit_PN532 #####
+Adafruit_PN532::Adafruit_PN532(uint8_t irq, uint8_t reset, TwoWire* theWire) : link(SIM_LINK_I2C) {
+}
+
+Adafruit_PN532::Adafruit_PN532(uint8_t ss, SPIClass* theSPI) : link(SIM_LINK_SPI) {
+}
+
+Adafruit_PN532::Adafruit_PN532(uint8_t reset, HardwareSerial* theSer) : link(SIM_LINK_HSU) {
+}
+
+// The driver runs SPI at 1 MHz and HSU at 115200 baud, I2C starts at 100 kHz until Wire.setClock()
+// All readers share the reset line, a begin() stops the pending detections of every channel.
+bool Adafruit_PN532::begin() {
+    for (uint8_t i = 0; i < SIM_MUX_CHANNELS; i++) pn532SimChannels[i].stopListening();
+    simSelectedReader().setLink(link, link == SIM_LINK_SPI ? 1000000 : (link == SIM_LINK_HSU ? 115200 : 100000));
+    return true;
+}
+
+// ##### Wire #####
+TwoWire Wire;
+
+void TwoWire::setClock(uint32_t frequency) {
+    for (uint8_t i = 0; i < SIM_MUX_CHANNELS; i++) pn532SimChannels[i].setLink(SIM_LINK_I2C, frequency);
+}
+
+void TwoWire::beginTransmission(uint8_t deviceAddress) {
+    address = deviceAddress;
+    length = 0;
+}
+
+size_t TwoWire::write(uint8_t value) {
+    data = value;
+    length++;
+    return 1;
+}
+
+// The multiplexer connects the lowest channel of the control byte, one channel at a time is
+// all the firmware uses. Other addresses get a NACK.
+uint8_t TwoWire::endTransmission() {
+    if (address != SIM_MUX_ADDRESS) return 2;
+
+    simAdvanceMicros((uint64_t)(length + 1) * simSelectedReader().timing.busByte);
+    if (length == 0 || data == 0) return 0;
+    simMuxSelects++;
+    for (uint8_t channel = 0; channel < SIM_MUX_CHANNELS; channel++) {
+        if (data & (1 << channel)) {
+            simMuxChannel = channel;
+            break;
+        }
+    }
+    return 0;
+}
+
+uint32_t Adafruit_PN532::getFirmwareVersion() {
+    simSelectedReader().stopListening();
+    simSelectedReader().command(2, 6);
+    return PN532_FIRMWARE_VERSION;
+}
+
+bool Adafruit_PN532::SAMConfig() {
+    simSelectedReader().stopListening();
+    simSelectedReader().command(5, 1);
+    return true;
+}
+
+bool Adafruit_PN532::setPassiveActivationRetries(uint8_t maxRetries) {
+    simSelectedReader().stopListening();
+    simSelectedReader().command(6, 1);
+    return true;
+}
+
+// Only the ACK is read, the response stays in the PN532 like on the real driver
+bool Adafruit_PN532::sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout) {
+    simSelectedReader().stopListening();
+    simSelectedReader().command(cmdlen, 0);
+    return true;
+}
+
+bool Adafruit_PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout, bool inlist) {
+    return simSelectedReader().activate(uid, uidLength, timeout);
+}
+
+bool Adafruit_PN532::startPassiveTargetIDDetection(uint8_t cardbaudrate) {
+    simSelectedReader().command(4, 0);
+    simSelectedReader().startListening();
+    return true;
+}
+
+bool Adafruit_PN532::readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength) {
+    return simSelectedReader().activate(uid, uidLength, 0);
+}
+
+bool Adafruit_PN532::inDataExchange(uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength) {
+    return simSelectedReader().exchange(send, sendLength, response, responseLength);
+}
+
+uint8_t Adafruit_PN532::ntag2xx_ReadPage(uint8_t page, uint8_t* buffer) {
+    uint8_t command[2] = { NTAG_CMD_READ, page };
+    uint8_t response[16];
+    uint8_t responseLength = sizeof(response);
+    if (!simSelectedReader().exchange(command, sizeof(command), response, &responseLength)) return 0;
+
+    // The driver only hands out the first page of the READ response
+    memcpy(buffer, response, 4);
+    return 1;
+}
+
+uint8_t Adafruit_PN532::ntag2xx_WritePage(uint8_t page, uint8_t* data) {
+    uint8_t command[6] = { NTAG_CMD_WRITE, page, data[0], data[1], data[2], data[3] };
+    uint8_t responseLength = 0;
+    return simSelectedReader().exchange(command, sizeof(command), NULL, &responseLength) ? 1 : 0;
+}
@@ -0,0 +1,622 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include "PN532Sim.h"
+#include "nfc.h"
+#include "ndef.h"
+#include "spoolCbor.h"
+#include "tagCache.h"
+#include "scale.h"
+#include "config.h"
+
+// Runs the NFC task against virtual tags and prints the PN532 traffic per operation.
+// Latency is simulated time from placing the tag (or queueing the write) to the event.
+
+#define BENCH_MAX_STEPS             20
+#define BENCH_HEAP_CYCLES           5
+#define BENCH_IDLE_TIME             60000U  // Simulated ms of an empty reader per idle scenario
+#define BENCH_MAX_READERS           4
+#define BENCH_READER_ROUNDS         200     // Task rounds until every reader must have read its tag
+#define BENCH_DECODE_ROUNDS         100000U // Decodes per decoder measurement
+#define BENCH_BURST_PAGES           12      // Pages of one FAST_READ burst, NTAG_FAST_READ_MAX_PAGES of nfc.cpp
+
+typedef enum {
+    EXPECT_SUCCESS,
+    EXPECT_FAILURE,
+    EXPECT_ANY              // Informational, the outcome depends on the retry strategy
+} benchExpectationType;
+
+static const uint8_t UID_SPOOL_JSON[7] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_SPOOL_CBOR[7] = { 0x04, 0x12, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_LOCATION[7]   = { 0x04, 0x13, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_WRITE[7]      = { 0x04, 0x14, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_READ_NAK[7]   = { 0x04, 0x15, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_LIFTED[7]     = { 0x04, 0x16, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_WRITE_NAK[7]  = { 0x04, 0x17, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_LOCKED[7]     = { 0x04, 0x18, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_RESUME[7]     = { 0x04, 0x1C, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_LINK[7]       = { 0x04, 0x1D, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_HEAP[7]       = { 0x04, 0x1E, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_WAKE[7]       = { 0x04, 0x1F, 0x22, 0x33, 0x44, 0x55, 0x80 };
+static const uint8_t UID_READERS[BENCH_MAX_READERS][7] = { { 0x04, 0x20, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                                           { 0x04, 0x21, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                                           { 0x04, 0x22, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                                           { 0x04, 0x23, 0x22, 0x33, 0x44, 0x55, 0x80 } };
+static const uint8_t UID_ROUND_TRIP[4][7] = { { 0x04, 0x24, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                              { 0x04, 0x25, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                              { 0x04, 0x26, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                              { 0x04, 0x27, 0x22, 0x33, 0x44, 0x55, 0x80 } };
+static const uint8_t UID_FULL_READ[3][7] = { { 0x04, 0x28, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                             { 0x04, 0x29, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                             { 0x04, 0x2A, 0x22, 0x33, 0x44, 0x55, 0x80 } };
+static const uint8_t UID_BATCH[3][7]   = { { 0x04, 0x19, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                           { 0x04, 0x1A, 0x22, 0x33, 0x44, 0x55, 0x80 },
+                                           { 0x04, 0x1B, 0x22, 0x33, 0x44, 0x55, 0x80 } };
+
+static const char* SPOOL_JSON =
+    "{\"sm_id\":\"42\",\"color_hex\":\"1A1A1A\",\"type\":\"PETG\",\"brand\":\"Sunlu\","
+    "\"an\":\"PETG Basic Black\",\"cw\":\"1000\",\"et\":\"240\",\"bt\":\"70\"}";
+static const char* SPOOL_CBOR_JSON =
+    "{\"sm_id\":\"43\",\"color_hex\":\"FFFFFF\",\"type\":\"PLA\",\"brand\":\"Bambu\","
+    "\"an\":\"PLA Matte Ivory White\",\"cw\":\"1000\",\"et\":\"220\",\"bt\":\"55\"}";
+static const char* LOCATION_JSON = "{\"location\":\"Shelf A3\"}";
+// More than 255 bytes in JSON and CBOR, written as a long record behind a 3 byte TLV length
+static const char* LONG_SPOOL_JSON =
+    "{\"sm_id\":\"44\",\"color_hex\":\"2E7D32\",\"type\":\"PLA\",\"brand\":\"Prusament\","
+    "\"an\":\"PLA Jungle Green\",\"cw\":\"1000\",\"et\":\"215\",\"bt\":\"60\","
+    "\"comment\":\"Opened in spring, dried for 6 h at 50 C before the first print. Keep in the dry box "
+    "with fresh silica gel, the spool picks up moisture quickly and strings on long travel moves. "
+    "Best results with 0.2 mm layers, 215 C nozzle and 60 C bed on the textured sheet. "
+    "Retraction 0.8 mm at 35 mm/s, no z-hop needed. Remaining length checked by weight, \\\"not\\\" by a \\\\ counter.\"}";
+
+static nfcEventType awaitedEvent;
+static bool eventSeen;
+static bool eventSuccess;
+static SimCounters eventCounters;
+static uint64_t eventMicros;
+static uint64_t scenarioStart;
+static uint8_t failedExpectations = 0;
+static uint32_t taskAllocations;    // Heap allocations made while the NFC task ran
+static uint8_t readersRead;         // Bit per reader with a successful read
+
+static void onNfcEvent(const NfcEvent& event) {
+    if (event.type == NFC_EVENT_READ_DONE && event.success) readersRead |= 1 << event.reader;
+    if (eventSeen || event.type != awaitedEvent) return;
+    eventSeen = true;
+    eventSuccess = event.success;
+    eventCounters = pn532Sim.counters();
+    eventMicros = simMicros();
+}
+
+static void beginScenario() {
+    pn532Sim.resetCounters();
+    scenarioStart = simMicros();
+}
+
+// Runs the NFC task until the event shows up, the counters are taken at that moment
+static bool runUntil(nfcEventType type) {
+    awaitedEvent = type;
+    eventSeen = false;
+    for (uint8_t step = 0; step < BENCH_MAX_STEPS && !eventSeen; step++) {
+        uint32_t allocations = simHeapAllocations();
+        nfcTaskStep();
+        taskAllocations += simHeapAllocations() - allocations;
+    }
+    return eventSeen;
+}
+
+static void report(const char* name, benchExpectationType expectation) {
+    bool done = eventSeen;
+    bool ok = done && eventSuccess;
+    bool met = expectation == EXPECT_ANY || (expectation == EXPECT_SUCCESS ? ok : done && !ok);
+    if (!met) failedExpectations++;
+
+    if (!done) {
+        printf("%-30s %-7s no event after %d task rounds\n", name, met ? "-" : "FAIL", BENCH_MAX_STEPS);
+        return;
+    }
+
+    printf("%-30s %-7s %5u %5u %5u %5u %5u %8.1f %9.1f\n", name,
+        met ? (ok ? "ok" : "failed") : "FAIL",
+        (unsigned int)eventCounters.transactions,
+        (unsigned int)eventCounters.tagCommands,
+        (unsigned int)eventCounters.pagesRead,
+        (unsigned int)eventCounters.pagesWritten,
+        (unsigned int)eventCounters.failures,
+        eventCounters.busMicros / 1000.0,
+        (eventMicros - scenarioStart) / 1000.0);
+}
+
+// Takes the tag away and lets the task notice it, so the next scenario starts idle
+static void clearField() {
+    pn532Sim.removeTag();
+    runUntil(NFC_EVENT_TAG_REMOVED);
+}
+
+// Tags as this firmware writes them, with the payload checksum in front of the message.
+// Without it the tag looks like one written by another app. Returns the image length, 0 if it does not fit.
+static size_t encodeNdefImage(const char* mimeType, const uint8_t* payload, uint16_t payloadLength, bool withChecksum,
+                              uint8_t* image, size_t size) {
+    uint16_t checksumLength = withChecksum ? ndefEncodeChecksumTlv(tagCacheCrc32(payload, payloadLength), image) : 0;
+    uint16_t messageLength = ndefEncodeMimeMessage(mimeType, payload, payloadLength, image + checksumLength, size - checksumLength);
+    return messageLength > 0 ? checksumLength + messageLength : 0;
+}
+
+static bool placeNdefTag(simTagModelType model, const uint8_t* uid, const char* mimeType, const uint8_t* payload, uint16_t payloadLength,
+                         bool withChecksum = true, PN532Sim& reader = pn532Sim) {
+    uint8_t image[SIM_NTAG_MAX_PAGES * 4];
+    size_t imageLength = encodeNdefImage(mimeType, payload, payloadLength, withChecksum, image, sizeof(image));
+    reader.placeTag(model, uid);
+    return imageLength > 0 && reader.loadUserData(image, imageLength);
+}
+
+static bool placeJsonTag(simTagModelType model, const uint8_t* uid, const char* json, bool withChecksum = true,
+                         PN532Sim& reader = pn532Sim) {
+    return placeNdefTag(model, uid, NDEF_MIME_JSON, (const uint8_t*)json, strlen(json), withChecksum, reader);
+}
+
+static bool placeCborTag(simTagModelType model, const uint8_t* uid, const char* json) {
+    JsonDocument doc;
+    uint8_t record[256];
+    if (deserializeJson(doc, json)) return false;
+    size_t recordLength = spoolCborEncode(doc.as<JsonObjectConst>(), record, sizeof(record));
+    return recordLength > 0 && placeNdefTag(model, uid, NDEF_MIME_CBOR, record, recordLength);
+}
+
+static void benchRead(const char* name, benchExpectationType expectation) {
+    beginScenario();
+    runUntil(NFC_EVENT_READ_DONE);
+    report(name, expectation);
+}
+
+static void benchWrite(const char* name, const char* json, nfcPayloadFormatType format, benchExpectationType expectation) {
+    beginScenario();
+    startWriteJsonToTag(true, json, format);
+    runUntil(NFC_EVENT_WRITE_DONE);
+    report(name, expectation);
+}
+
+// Tags are swapped without a pause, only the NFC task's own delays count
+static void benchBatch(const char* name, nfcPayloadFormatType format) {
+    JsonDocument doc;
+    for (uint8_t i = 0; i < 3; i++) {
+        JsonDocument payload;
+        deserializeJson(payload, SPOOL_JSON);
+        payload["sm_id"] = String(50 + i);
+        doc.add(payload.as<JsonObjectConst>());
+    }
+
+    beginScenario();
+    startBatchWrite(true, doc.as<JsonArrayConst>(), format);
+    for (uint8_t i = 0; i < 3; i++) {
+        pn532Sim.placeTag(SIM_NTAG213, UID_BATCH[i]);
+        runUntil(i < 2 ? NFC_EVENT_WRITE_DONE : NFC_EVENT_BATCH_DONE);
+    }
+    report(name, EXPECT_SUCCESS);
+}
+
+// Write and the removal that follows, counted from the write command. The NFC task must not
+// hold the write until the tag is gone, the presence checks report the removal.
+static void benchWriteRemoval(const char* name, const char* json) {
+    beginScenario();
+    startWriteJsonToTag(true, json);
+    runUntil(NFC_EVENT_WRITE_DONE);
+    pn532Sim.removeTag();
+    runUntil(NFC_EVENT_TAG_REMOVED);
+    report(name, EXPECT_SUCCESS);
+}
+
+static void benchRemoval(const char* name) {
+    beginScenario();
+    pn532Sim.removeTag();
+    runUntil(NFC_EVENT_TAG_REMOVED);
+    report(name, EXPECT_SUCCESS);
+}
+
+// Full read of a tag filled to the end by its record. sm_id is the last field, so the whole NDEF area
+// is read. Page by page that is one READ per page; the bursts may take no more tag commands than
+// frames of BENCH_BURST_PAGES for the pages read, plus GET_VERSION.
+static void benchFullRead(const char* name, simTagModelType model, const uint8_t* uid) {
+    static const char head[] = "{\"comment\":\"";
+    static const char tail[] = "\",\"sm_id\":\"45\"}";
+    char json[SIM_NTAG_MAX_PAGES * 4];
+
+    // Longest comment that still fits the tag with the NDEF framing, no checksum so the cache cannot answer
+    pn532Sim.placeTag(model, uid);
+    size_t fill = (pn532Sim.lastUserPage() - 3) * 4 - (sizeof(head) - 1) - (sizeof(tail) - 1);
+    bool placed = false;
+    for (; fill > 0 && !placed; fill--) {
+        memcpy(json, head, sizeof(head) - 1);
+        memset(json + sizeof(head) - 1, 'x', fill);
+        memcpy(json + sizeof(head) - 1 + fill, tail, sizeof(tail));
+        placed = placeJsonTag(model, uid, json, false);
+    }
+
+    beginScenario();
+    bool ok = placed && runUntil(NFC_EVENT_READ_DONE) && eventSuccess;
+    SimCounters read = eventCounters;
+    clearField();
+
+    uint32_t bursts = (read.pagesRead + BENCH_BURST_PAGES - 1) / BENCH_BURST_PAGES;
+    ok = ok && read.tagCommands <= bursts + 1;
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s %7u %5u %5u %8u\n", name, ok ? "ok" : "FAIL", (unsigned int)strlen(json),
+        (unsigned int)read.pagesRead, (unsigned int)read.tagCommands, (unsigned int)read.pagesRead + 1);
+}
+
+// Host link throughput: full read of a tag without checksum (the cache cannot answer) and a
+// complete write to an empty NTAG216, both counted until their event
+static void benchLink(const char* name, simLinkType link, uint32_t clockHz) {
+    SimCounters read;
+    SimCounters write;
+    pn532Sim.setLink(link, clockHz);
+
+    placeJsonTag(SIM_NTAG213, UID_LINK, SPOOL_JSON, false);
+    beginScenario();
+    bool readOk = runUntil(NFC_EVENT_READ_DONE) && eventSuccess;
+    read = eventCounters;
+    clearField();
+
+    pn532Sim.placeTag(SIM_NTAG216, UID_LINK);
+    beginScenario();
+    startWriteJsonToTag(true, SPOOL_JSON, NFC_FORMAT_JSON);
+    bool writeOk = runUntil(NFC_EVENT_WRITE_DONE) && eventSuccess;
+    write = eventCounters;
+    clearField();
+
+    if (!readOk || !writeOk) failedExpectations++;
+    printf("%-16s %-7s %6u %7u %8.1f %6u %7u %8.1f\n", name, readOk && writeOk ? "ok" : "FAIL",
+        (unsigned int)read.frames, (unsigned int)read.busBytes, read.busMicros / 1000.0,
+        (unsigned int)write.frames, (unsigned int)write.busBytes, write.busMicros / 1000.0);
+}
+
+// Scan cycles from detection to removal must not touch the heap. The first cycle fills the
+// caches, the counted ones find everything in place. Only the NFC task is counted.
+// The subscribers of api.cpp and website.cpp are not built here, they need the network stack.
+// Inside the NFC task they only find sm_id in place and queue the event for their worker tasks
+// (spoolPrefetchTask, websiteNfcTask), which do the allocating work.
+static void benchHeap(const char* name, const uint8_t* uid, const char* json, bool withChecksum) {
+    placeJsonTag(SIM_NTAG213, uid, json, withChecksum);
+    runUntil(NFC_EVENT_READ_DONE);
+    clearField();
+    tagCacheFlush(true);
+
+    bool ok = true;
+    taskAllocations = 0;
+    for (uint8_t i = 0; i < BENCH_HEAP_CYCLES; i++) {
+        placeJsonTag(SIM_NTAG213, uid, json, withChecksum);
+        ok = runUntil(NFC_EVENT_READ_DONE) && eventSuccess && ok;
+        clearField();
+    }
+
+    ok = ok && taskAllocations == 0;
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s %6.1f\n", name, ok ? "ok" : "FAIL", taskAllocations / (double)BENCH_HEAP_CYCLES);
+}
+
+// Writes through the NFC task (ntag2xx_WriteNDEF) and decodes the user memory the write left on
+// the tag: the record must be complete, carry the checksum of its payload and decode to what was sent
+static void benchRoundTrip(const char* name, simTagModelType model, const uint8_t* uid, const char* json, nfcPayloadFormatType format) {
+    pn532Sim.placeTag(model, uid);
+    startWriteJsonToTag(true, json, format);
+    bool ok = runUntil(NFC_EVENT_WRITE_DONE) && eventSuccess;
+
+    uint8_t image[SIM_NTAG_MAX_PAGES * 4];
+    size_t imageLength = 0;
+    for (uint8_t page = 4; page <= pn532Sim.lastUserPage(); page++, imageLength += 4) {
+        memcpy(&image[imageLength], pn532Sim.page(page), 4);
+    }
+    clearField();
+
+    NdefRecordView record = {};
+    JsonDocument sent;
+    JsonDocument decoded;
+    uint32_t checksum = 0;
+    deserializeJson(sent, json);
+    if (format == NFC_FORMAT_CBOR) {
+        ok = ok && ndefFindMimeRecord(image, imageLength, NDEF_MIME_CBOR, &record) &&
+             spoolCborDecode(record.payload, record.availableLength, decoded);
+    } else {
+        ok = ok && ndefFindJsonRecord(image, imageLength, &record) &&
+             !deserializeJson(decoded, (const char*)record.payload, record.availableLength);
+    }
+    ok = ok && record.availableLength == record.payloadLength &&
+         ndefFindChecksum(image, imageLength, &checksum) && checksum == tagCacheCrc32(record.payload, record.payloadLength) &&
+         decoded.as<JsonVariantConst>() == sent.as<JsonVariantConst>();
+
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s %7u %-6s\n", name, ok ? "ok" : "FAIL", (unsigned int)record.payloadLength,
+        record.payloadLength == 0 ? "-" : ((record.header & NDEF_FLAG_SR) ? "short" : "long"));
+}
+
+static void reportCheck(const char* name, bool ok) {
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s\n", name, ok ? "ok" : "FAIL");
+}
+
+// sm_id of a JSON record as the fast path reads it, 0 if it is missing or cut off
+static uint32_t decodeSpoolId(const uint8_t* image, size_t length, NdefRecordView* record) {
+    const char* value;
+    size_t valueLength;
+    if (!ndefFindJsonRecord(image, length, record)) return 0;
+    if (!jsonFindValue((const char*)record->payload, record->availableLength, "sm_id", &value, &valueLength)) return 0;
+    return jsonValueToUint(value, valueLength);
+}
+
+// Decoder edge cases on images built here: long records, every possible cut of the NDEF area as a
+// partial read leaves it, and sm_id values that end at the buffer end
+static void benchDecoderEdges() {
+    uint8_t image[SIM_NTAG_MAX_PAGES * 4];
+    size_t longJsonLength = strlen(LONG_SPOOL_JSON);
+    size_t imageLength = encodeNdefImage(NDEF_MIME_JSON, (const uint8_t*)LONG_SPOOL_JSON, longJsonLength, true, image, sizeof(image));
+
+    NdefRecordView record = {};
+    bool ok = imageLength > 0 && image[NDEF_CHECKSUM_TLV_SIZE] == NDEF_TLV_MESSAGE && image[NDEF_CHECKSUM_TLV_SIZE + 1] == 0xFF &&
+              decodeSpoolId(image, imageLength, &record) == 44 && !(record.header & NDEF_FLAG_SR) &&
+              record.payloadLength == longJsonLength && record.availableLength == longJsonLength &&
+              memcmp(record.payload, LONG_SPOOL_JSON, longJsonLength) == 0;
+    reportCheck("long record, 3 byte tlv length", ok);
+
+    // A cut record is never read beyond the cut, and sm_id is either complete or not found
+    ok = true;
+    for (size_t cut = 0; cut < imageLength; cut++) {
+        uint32_t smId = decodeSpoolId(image, cut, &record);
+        bool found = ndefFindJsonRecord(image, cut, &record);
+        if (found && (record.payload + record.availableLength > image + cut || record.availableLength > record.payloadLength)) ok = false;
+        if (smId != 0 && smId != 44) ok = false;
+    }
+    reportCheck("long record, every cut", ok);
+
+    // Cut inside the TLV header, the record header and the MIME type
+    ok = true;
+    for (size_t cut = 0; cut <= NDEF_CHECKSUM_TLV_SIZE + 4 + 6 + 16; cut++) {
+        if (ndefFindJsonRecord(image, cut, &record) && record.availableLength > 0) ok = false;
+    }
+    reportCheck("truncated tlv and record head", ok);
+
+    // sm_id cut at the end of the loaded bytes must not be taken as a shorter number
+    static const char* const CUT_VALUES[] = { "{\"sm_id\":\"4", "{\"sm_id\":44", "{\"sm_id\":", "{\"sm_", "{\"sm_id\":\"4\\" };
+    const char* value;
+    size_t valueLength;
+    ok = true;
+    for (size_t i = 0; i < sizeof(CUT_VALUES) / sizeof(CUT_VALUES[0]); i++) {
+        if (jsonFindValue(CUT_VALUES[i], strlen(CUT_VALUES[i]), "sm_id", &value, &valueLength)) ok = false;
+    }
+    ok = ok && jsonFindValue("{\"sm_id\":44}", 12, "sm_id", &value, &valueLength) && jsonValueToUint(value, valueLength) == 44;
+    reportCheck("cut-off sm_id values", ok);
+}
+
+// Host CPU time of one fast path decode: TLVs, record and sm_id of an image already in memory.
+// Wall clock of this machine, not simulated time, so only comparable within one run.
+static void benchDecode(const char* name, const char* mimeType, const uint8_t* payload, uint16_t payloadLength, uint32_t smId) {
+    uint8_t image[SIM_NTAG_MAX_PAGES * 4];
+    size_t imageLength = encodeNdefImage(mimeType, payload, payloadLength, true, image, sizeof(image));
+    bool cbor = strcmp(mimeType, NDEF_MIME_CBOR) == 0;
+
+    uint64_t sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_DECODE_ROUNDS; i++) {
+        NdefRecordView record;
+        uint32_t decoded = 0;
+        if (cbor) {
+            if (ndefFindMimeRecord(image, imageLength, NDEF_MIME_CBOR, &record)) spoolCborSpoolId(record.payload, record.availableLength, &decoded);
+        } else {
+            decoded = decodeSpoolId(image, imageLength, &record);
+        }
+        sum += decoded; // Keeps the loop from being optimized away
+    }
+    double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    bool ok = imageLength > 0 && sum == (uint64_t)smId * BENCH_DECODE_ROUNDS;
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s %7u %10.1f\n", name, ok ? "ok" : "FAIL", (unsigned int)imageLength, nanos / BENCH_DECODE_ROUNDS);
+}
+
+static void runFor(uint32_t ms) {
+    uint64_t end = simMicros() + (uint64_t)ms * 1000;
+    while (simMicros() < end) nfcTaskStep();
+}
+
+// PN532 traffic of an empty reader. Without load the task falls back to duty cycling once the
+// hold time after the last activity is over, the settling time before that is not counted.
+static void benchIdle(const char* name, int16_t load) {
+    weight = load;
+    runFor(NFC_ACTIVE_HOLD_TIME + NFC_IDLE_POLL_INTERVAL);
+
+    beginScenario();
+    runFor(BENCH_IDLE_TIME);
+
+    SimCounters idle = pn532Sim.counters();
+    printf("%-30s %6u %8.1f %8.1f\n", name, (unsigned int)idle.transactions, idle.busMicros / 1000.0,
+        idle.transactions * 60000.0 / BENCH_IDLE_TIME);
+}
+
+// Tag put on a duty cycling reader, found by the next poll. The sim runs the task in whole rounds, so
+// the tag always arrives right after a pause and the wake-up by a weight step cannot be shown here.
+static void benchWake(const char* name) {
+    weight = 0;
+    runFor(NFC_ACTIVE_HOLD_TIME + NFC_IDLE_POLL_INTERVAL);
+
+    placeJsonTag(SIM_NTAG213, UID_WAKE, SPOOL_JSON);
+    beginScenario();
+    runUntil(NFC_EVENT_READ_DONE);
+    report(name, EXPECT_SUCCESS);
+    clearField();
+}
+
+// One tag put on every reader at the same moment, all of them without checksum so each one is
+// read in full. Counted until the last reader reported its tag.
+static void benchReaders(const char* name, uint8_t count) {
+    NfcReaderConfig readers[BENCH_MAX_READERS];
+    for (uint8_t i = 0; i < count; i++) {
+        readers[i].muxChannel = i;
+        readers[i].irqPin = i == 0 ? PN532_IRQ : 2 + i;
+        pn532SimChannels[i].irqPin = readers[i].irqPin;
+    }
+    bool ok = nfcSetReaders(readers, count);
+    runFor(NFC_READER_ROUND_INTERVAL * 2); // Every reader has its detection pending
+
+    for (uint8_t i = 0; i < count; i++) {
+        placeJsonTag(SIM_NTAG213, UID_READERS[i], SPOOL_JSON, false, pn532SimChannels[i]);
+        pn532SimChannels[i].resetCounters();
+    }
+    uint32_t muxSelects = simMuxSelects;
+    uint64_t start = simMicros();
+    uint8_t all = (1 << count) - 1;
+    readersRead = 0;
+    for (uint16_t round = 0; round < BENCH_READER_ROUNDS && readersRead != all; round++) nfcTaskStep();
+    double totalMs = (simMicros() - start) / 1000.0;
+
+    uint32_t transactions = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        transactions += pn532SimChannels[i].counters().transactions;
+        pn532SimChannels[i].removeTag();
+    }
+    runFor(NFC_PRESENCE_CHECK_INTERVAL * 4); // Removals noticed, the next scenario starts idle
+
+    ok = ok && readersRead == all;
+    if (!ok) failedExpectations++;
+    printf("%-30s %-7s %5u %6u %9.1f %8.1f\n", name, ok ? "ok" : "FAIL", (unsigned int)transactions,
+        (unsigned int)(simMuxSelects - muxSelects), totalMs, totalMs / count);
+}
+
+int main() {
+    simSerialOutput = false;
+    weight = 1000; // Spool on the scale, the reader polls at full rate
+    nfcSubscribe(onNfcEvent);
+    startNfc();
+
+    printf("%-30s %-7s %5s %5s %5s %5s %5s %8s %9s\n",
+        "scenario", "result", "cmds", "tag", "rdPg", "wrPg", "fail", "bus ms", "total ms");
+
+    // Reads of spool tags, the second one is answered by the tag cache after checking the checksum
+    placeJsonTag(SIM_NTAG213, UID_SPOOL_JSON, SPOOL_JSON);
+    benchRead("json spool, known sm_id", EXPECT_SUCCESS);
+    clearField();
+
+    placeJsonTag(SIM_NTAG213, UID_SPOOL_JSON, SPOOL_JSON);
+    benchRead("json spool, cached uid", EXPECT_SUCCESS);
+    clearField();
+
+    // Same UID rewritten by another app: the checksum is gone, the cache must not answer
+    placeJsonTag(SIM_NTAG213, UID_SPOOL_JSON, SPOOL_JSON, false);
+    benchRead("json spool, edited elsewhere", EXPECT_SUCCESS);
+    clearField();
+
+    placeCborTag(SIM_NTAG215, UID_SPOOL_CBOR, SPOOL_CBOR_JSON);
+    benchRead("cbor spool, ntag215", EXPECT_SUCCESS);
+    clearField();
+
+    placeJsonTag(SIM_NTAG213, UID_LOCATION, LOCATION_JSON);
+    benchRead("location tag, full read", EXPECT_SUCCESS);
+    clearField();
+
+    // Location tags are cached like spools, a relocation session starts with one checksum read
+    placeJsonTag(SIM_NTAG213, UID_LOCATION, LOCATION_JSON);
+    benchRead("location tag, cached uid", EXPECT_SUCCESS);
+    clearField();
+
+    // Presence tracking: a tag put in place of another one is read at once
+    placeJsonTag(SIM_NTAG213, UID_SPOOL_JSON, SPOOL_JSON);
+    runUntil(NFC_EVENT_READ_DONE);
+    placeCborTag(SIM_NTAG215, UID_SPOOL_CBOR, SPOOL_CBOR_JSON);
+    benchRead("swapped tag, cached uid", EXPECT_SUCCESS);
+    benchRemoval("tag removal");
+
+    // Writes, the second one finds every page already up to date
+    pn532Sim.placeTag(SIM_NTAG216, UID_WRITE);
+    benchWrite("json write, ntag216", SPOOL_JSON, NFC_FORMAT_JSON, EXPECT_SUCCESS);
+    benchWrite("json rewrite, unchanged", SPOOL_JSON, NFC_FORMAT_JSON, EXPECT_SUCCESS);
+    benchWrite("cbor write, ntag216", SPOOL_JSON, NFC_FORMAT_CBOR, EXPECT_SUCCESS);
+    benchWriteRemoval("json write, then removal", SPOOL_JSON);
+
+    benchBatch("batch of 3, swapped tags", NFC_FORMAT_CBOR);
+    clearField();
+
+    // Injected faults, every tag has its own UID so the cache cannot answer
+    placeJsonTag(SIM_NTAG213, UID_READ_NAK, SPOOL_JSON);
+    pn532Sim.failReads(4, 1);
+    benchRead("read, one nak on page 4", EXPECT_SUCCESS);
+    clearField();
+
+    // Gone right after GET_VERSION, before the first page burst
+    placeJsonTag(SIM_NTAG213, UID_LIFTED, SPOOL_JSON);
+    pn532Sim.removeTagAfter(1);
+    benchRead("read, tag lifted mid-read", EXPECT_FAILURE);
+    clearField();
+
+    pn532Sim.placeTag(SIM_NTAG213, UID_WRITE_NAK);
+    pn532Sim.failWrites(5, 1);
+    benchWrite("write, one nak on page 5", SPOOL_JSON, NFC_FORMAT_JSON, EXPECT_SUCCESS);
+    clearField();
+
+    // Lifted during the page writes and back 2 s later, the write continues where it stopped
+    pn532Sim.placeTag(SIM_NTAG213, UID_RESUME);
+    pn532Sim.removeTagAfter(30, 2000);
+    benchWrite("write, lifted and put back", SPOOL_JSON, NFC_FORMAT_JSON, EXPECT_SUCCESS);
+    clearField();
+
+    pn532Sim.placeTag(SIM_NTAG213, UID_LOCKED);
+    pn532Sim.lockPage(6);
+    benchWrite("write, page 6 locked", SPOOL_JSON, NFC_FORMAT_JSON, EXPECT_FAILURE);
+    clearField();
+
+    printf("\n%-30s %-7s %7s %5s %5s %8s\n", "full read", "result", "payload", "rdPg", "tag", "per page");
+    benchFullRead("json, ntag213", SIM_NTAG213, UID_FULL_READ[0]);
+    benchFullRead("json, ntag215", SIM_NTAG215, UID_FULL_READ[1]);
+    benchFullRead("json, ntag216", SIM_NTAG216, UID_FULL_READ[2]);
+
+    printf("\n%-30s %-7s %7s %-6s\n", "round trip", "result", "payload", "record");
+    benchRoundTrip("json, ntag213", SIM_NTAG213, UID_ROUND_TRIP[0], SPOOL_JSON, NFC_FORMAT_JSON);
+    benchRoundTrip("json long, ntag216", SIM_NTAG216, UID_ROUND_TRIP[1], LONG_SPOOL_JSON, NFC_FORMAT_JSON);
+    benchRoundTrip("cbor, ntag213", SIM_NTAG213, UID_ROUND_TRIP[2], SPOOL_CBOR_JSON, NFC_FORMAT_CBOR);
+    benchRoundTrip("cbor long, ntag216", SIM_NTAG216, UID_ROUND_TRIP[3], LONG_SPOOL_JSON, NFC_FORMAT_CBOR);
+
+    printf("\n%-30s %-7s\n", "decoder edge case", "result");
+    benchDecoderEdges();
+
+    printf("\n%-30s %-7s %7s %10s\n", "decoder", "result", "bytes", "ns/decode");
+    benchDecode("json spool", NDEF_MIME_JSON, (const uint8_t*)SPOOL_JSON, strlen(SPOOL_JSON), 42);
+    benchDecode("json spool, long record", NDEF_MIME_JSON, (const uint8_t*)LONG_SPOOL_JSON, strlen(LONG_SPOOL_JSON), 44);
+    {
+        JsonDocument doc;
+        uint8_t record[256];
+        deserializeJson(doc, SPOOL_CBOR_JSON);
+        size_t recordLength = spoolCborEncode(doc.as<JsonObjectConst>(), record, sizeof(record));
+        benchDecode("cbor spool", NDEF_MIME_CBOR, record, recordLength, 43);
+    }
+
+    printf("\n%-30s %-7s %6s\n", "scan cycle", "result", "allocs");
+    benchHeap("json spool, cached uid", UID_SPOOL_JSON, SPOOL_JSON, true);
+    benchHeap("json spool, full read", UID_HEAP, SPOOL_JSON, false);
+    benchHeap("location tag, cached uid", UID_LOCATION, LOCATION_JSON, true);
+
+    printf("\n%-16s %-7s %6s %7s %8s %6s %7s %8s\n",
+        "link", "result", "rdFrm", "rdByte", "rd ms", "wrFrm", "wrByte", "wr ms");
+    benchLink("i2c 100 kHz", SIM_LINK_I2C, 100000);
+    benchLink("i2c 400 kHz", SIM_LINK_I2C, 400000);
+    benchLink("spi 1 MHz", SIM_LINK_SPI, 1000000);
+    benchLink("hsu 115200", SIM_LINK_HSU, 115200);
+
+    printf("\n%-30s %-7s %5s %5s %5s %5s %5s %8s %9s\n",
+        "duty cycle", "result", "cmds", "tag", "rdPg", "wrPg", "fail", "bus ms", "total ms");
+    benchWake("tag on empty scale");
+
+    printf("\n%-30s %6s %8s %8s\n", "idle reader", "cmds", "bus ms", "cmd/min");
+    benchIdle("spool on the scale", 1000);
+    benchIdle("empty scale, duty cycle", 0);
+    weight = 1000;
+
+    // Shelf readers behind the multiplexer, scanned round-robin with the scale reader
+    printf("\n%-30s %-7s %5s %6s %9s %8s\n", "readers", "result", "cmds", "mux", "total ms", "ms/tag");
+    benchReaders("scale reader only", 1);
+    benchReaders("scale + 1 shelf reader", 2);
+    benchReaders("scale + 3 shelf readers", 4);
+    nfcSetReaders(NFC_READERS, NFC_READER_COUNT);
+
+    if (failedExpectations > 0) {
+        printf("%u scenario(s) did not end as expected\n", (unsigned int)failedExpectations);
+        return 1;
+    }
+    return 0;
+}
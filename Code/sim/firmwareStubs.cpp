@@ -0,0 +1,35 @@
+#include <Arduino.h>
+#include "api.h"
+#include "bambu.h"
+#include "display.h"
+#include "main.h"
+#include "scale.h"
+
+// Stand-ins for the firmware parts the NFC code calls into. The simulator acts as a
+// connected Spoolman without display, scale or printer.
+
+bool booting = false;
+bool spoolmanConnected = true;
+bool octoEnabled = false;
+int16_t weight = 0;
+BambuCredentials bambuCredentials;
+
+void oledShowProgressBar(const uint8_t step, const uint8_t numSteps, const char* largeText, const char* statusMessage) {
+}
+
+void oledShowWeight(uint16_t weight) {
+}
+
+void oledShowMessage(const String &message, uint8_t size) {
+}
+
+void oledShowIcon(const char* icon) {
+}
+
+uint8_t updateSpoolLocation(uint32_t spoolId, const char* location) {
+    return 1;
+}
+
+bool queueBrandFilament(const char* json, const char* uidString) {
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef ADAFRUIT_PN532_H
+#define ADAFRUIT_PN532_H
+
+#include <Arduino.h>
+#include "PN532Sim.h"
+
+// Host replacement of the Adafruit PN532 driver, limited to the calls the firmware uses.
+// Every call is served by pn532Sim and counted there.
+
+#define PN532_MIFARE_ISO14443A      (0x00)
+#define PN532_COMMAND_RFCONFIGURATION (0x32)
+
+class TwoWire;
+class SPIClass;
+
+// The constructor picks the link like on the real driver, begin() applies its timing to pn532Sim
+class Adafruit_PN532 {
+public:
+    Adafruit_PN532(uint8_t irq, uint8_t reset, TwoWire* theWire = nullptr);
+    Adafruit_PN532(uint8_t ss, SPIClass* theSPI = nullptr);
+    Adafruit_PN532(uint8_t reset, HardwareSerial* theSer);
+
+    bool begin();
+    uint32_t getFirmwareVersion();
+    bool SAMConfig();
+    bool setPassiveActivationRetries(uint8_t maxRetries);
+    bool sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout = 100);
+
+    bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 0, bool inlist = false);
+    bool startPassiveTargetIDDetection(uint8_t cardbaudrate);
+    bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength);
+    bool inDataExchange(uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength);
+
+    uint8_t ntag2xx_ReadPage(uint8_t page, uint8_t* buffer);
+    uint8_t ntag2xx_WritePage(uint8_t page, uint8_t* data);
+
+private:
+    simLinkType link;
+};
+
+#endif
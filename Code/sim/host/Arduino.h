@@ -0,0 +1,172 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Minimal Arduino core for the native simulator environment. Time is simulated: delays
+// and PN532 transactions advance a virtual clock instead of sleeping.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include "freertosSim.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX                         16
+#define DEC                         10
+#define LOW                         0
+#define HIGH                        1
+#define INPUT                       0x01
+#define OUTPUT                      0x03
+#define INPUT_PULLUP                0x05
+#define RISING                      0x01
+#define FALLING                     0x02
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+// ##### Heap, counts the allocations of the code under test #####
+uint32_t simHeapAllocations();
+
+// ##### Simulated clock #####
+void simAdvanceMicros(uint64_t micros);
+uint64_t simMicros();
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void yield();
+
+// ##### Pins, reads return the PN532 IRQ line #####
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(pin)  (pin)
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// ##### String #####
+class String {
+public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const char* text, size_t length) : value(text ? std::string(text, length) : std::string()) {}
+    String(const std::string& text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    String(unsigned char number, unsigned char base = DEC) : value(fromUnsigned(number, base)) {}
+    String(int number, unsigned char base = DEC) : value(fromSigned(number, base)) {}
+    String(unsigned int number, unsigned char base = DEC) : value(fromUnsigned(number, base)) {}
+    String(long number, unsigned char base = DEC) : value(fromSigned(number, base)) {}
+    String(unsigned long number, unsigned char base = DEC) : value(fromUnsigned(number, base)) {}
+    String(long long number, unsigned char base = DEC) : value(fromSigned(number, base)) {}
+    String(unsigned long long number, unsigned char base = DEC) : value(fromUnsigned(number, base)) {}
+    String(double number, unsigned int decimalPlaces = 2) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, number);
+        value = buffer;
+    }
+
+    String& operator=(const char* text) { value = text ? text : ""; return *this; }
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+    long toInt() const { return atol(value.c_str()); }
+    float toFloat() const { return atof(value.c_str()); }
+
+    bool concat(const String& text) { value += text.value; return true; }
+    bool concat(const char* text) { if (!text) return false; value += text; return true; }
+    bool concat(char c) { value += c; return true; }
+
+    String& operator+=(const String& text) { concat(text); return *this; }
+    String& operator+=(const char* text) { concat(text); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == (other ? other : ""); }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+private:
+    static std::string fromUnsigned(unsigned long long number, unsigned char base) {
+        char buffer[65];
+        char* p = &buffer[sizeof(buffer) - 1];
+        *p = '\0';
+        if (base < 2) base = 10;
+        do {
+            uint8_t digit = number % base;
+            *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+            number /= base;
+        } while (number > 0);
+        return p;
+    }
+
+    static std::string fromSigned(long long number, unsigned char base) {
+        if (base == DEC && number < 0) return "-" + fromUnsigned(-(unsigned long long)number, base);
+        return fromUnsigned((unsigned long long)number, base);
+    }
+
+    std::string value;
+};
+
+inline String operator+(const String& a, const String& b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, const char* b) { String result(a); result += b; return result; }
+inline String operator+(const char* a, const String& b) { String result(a); result += b; return result; }
+inline bool operator==(const char* a, const String& b) { return b == a; }
+inline bool operator!=(const char* a, const String& b) { return b != a; }
+
+// ##### Serial #####
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) {}
+    void begin(unsigned long baud, uint32_t config, int8_t rxPin = -1, int8_t txPin = -1) {}
+    void setDebugOutput(bool enable) {}
+
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { char text[2] = { c, '\0' }; return write(text); }
+    size_t print(unsigned char number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    // Formatted on the stack like the Arduino core, printing numbers does not allocate
+    size_t print(long number, int base = DEC) { return number < 0 && base == DEC ? print('-') + print((unsigned long long)-(long long)number, base) : print((unsigned long long)number, base); }
+    size_t print(unsigned long number, int base = DEC) { return print((unsigned long long)number, base); }
+    size_t print(long long number, int base = DEC) { return number < 0 && base == DEC ? print('-') + print((unsigned long long)-number, base) : print((unsigned long long)number, base); }
+    size_t print(unsigned long long number, int base = DEC) {
+        char text[66];
+        char* digit = &text[sizeof(text) - 1];
+        *digit = '\0';
+        do {
+            unsigned int value = number % base;
+            *--digit = value < 10 ? '0' + value : 'A' + value - 10;
+            number /= base;
+        } while (number > 0);
+        return write(digit);
+    }
+    size_t print(double number, int digits = 2) { return write(String(number, digits).c_str()); }
+
+    size_t println() { return write("\n"); }
+    template <typename T> size_t println(const T& value) { return print(value) + println(); }
+    template <typename T> size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t write(const char* text);
+};
+
+#define SERIAL_8N1                  0x800001c
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;  // PN532 HSU link, the simulator does not use the port
+extern bool simSerialOutput;    // false silences the firmware log, e.g. for benchmarks
+
+#endif
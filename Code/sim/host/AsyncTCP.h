@@ -0,0 +1,4 @@
+#ifndef ASYNCTCP_H
+#define ASYNCTCP_H
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef ESPASYNCWEBSERVER_H
+#define ESPASYNCWEBSERVER_H
+
+// The web server is not part of the simulator, the firmware headers only need the types
+class AsyncWebServer;
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+class AsyncWebServerRequest;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef HX711_H
+#define HX711_H
+
+class HX711;
+
+#endif
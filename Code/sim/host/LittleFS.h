@@ -0,0 +1,36 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+#include <Arduino.h>
+#include <string>
+
+// In-memory file system, enough for the tag cache file
+
+class File {
+public:
+    File() : data(nullptr), position(0), writing(false) {}
+    File(std::string* fileData, bool writeMode) : data(fileData), position(0), writing(writeMode) {}
+
+    operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    size_t read(uint8_t* buffer, size_t length);
+    size_t write(const uint8_t* buffer, size_t length);
+    void close() { data = nullptr; }
+
+private:
+    std::string* data;
+    size_t position;
+    bool writing;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail = false) { return true; }
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
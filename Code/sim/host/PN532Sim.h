@@ -0,0 +1,121 @@
+#ifndef PN532SIM_H
+#define PN532SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Simulated PN532 field with one virtual NTAG21x tag. Backs the host version of
+// Adafruit_PN532 so the NFC code can run in the native environment.
+
+#define SIM_NTAG_MAX_PAGES          231     // NTAG216
+#define SIM_PN532_MAX_DATA          55      // InDataExchange data that fits the 64 byte packet buffer
+#define SIM_PN532_FRAMING_BYTES     22      // Header and checksums of request and response frame plus the ACK frame
+#define SIM_PN532_READY_MICROS      200     // Ready polling (I2C, SPI) or frame gaps (HSU) per command
+#define SIM_MUX_ADDRESS             0x70    // TCA9548A in front of the readers
+#define SIM_MUX_CHANNELS            8
+#define SIM_IRQ_UNWIRED             0xFF
+
+typedef enum {
+    SIM_NTAG213,
+    SIM_NTAG215,
+    SIM_NTAG216
+} simTagModelType;
+
+// Host link to the PN532
+typedef enum {
+    SIM_LINK_I2C,
+    SIM_LINK_SPI,
+    SIM_LINK_HSU
+} simLinkType;
+
+// Timing model, all values in microseconds
+typedef struct {
+    uint32_t busByte;           // One byte on the host link, see setLink()
+    uint32_t frameOverhead;     // Frame header, ACK frame and ready polling per command
+    uint32_t pn532Processing;   // PN532 firmware time per command
+    uint32_t rfByte;            // One byte over the air at 106 kbit/s incl. parity
+    uint32_t activation;        // Anticollision and select of a 7 byte UID
+    uint32_t tagWrite;          // EEPROM programming time of one page
+} SimTiming;
+
+typedef struct {
+    uint32_t transactions;      // PN532 commands
+    uint32_t frames;            // Frames on the host link: request, ACK and response per command
+    uint32_t busBytes;          // Bytes on the host link including the framing
+    uint32_t tagCommands;       // Commands that reached the tag
+    uint32_t pagesRead;
+    uint32_t pagesWritten;
+    uint32_t failures;          // NAKs and timeouts, injected or caused by the command
+    uint64_t busMicros;         // Simulated time spent on the bus and in the field
+} SimCounters;
+
+class PN532Sim {
+public:
+    PN532Sim();
+
+    void placeTag(simTagModelType model, const uint8_t* uid);
+    void removeTag();
+    void removeTagAfter(uint32_t tagCommands, uint32_t returnAfterMs = 0);  // Tag answers this many more commands, then
+                                                                            // leaves; put back with its memory after returnAfterMs
+    bool tagPresent() const { return present; }
+
+    // Preloads user memory starting at page 4, e.g. with an NDEF TLV image
+    bool loadUserData(const uint8_t* data, size_t length);
+    const uint8_t* page(uint8_t page) const { return memory[page]; }
+    uint8_t lastUserPage() const;
+
+    // Page locks: pages 3-15 also set the static lock bits in page 2
+    void lockPage(uint8_t page);
+
+    // The next count accesses touching page fail with a NAK
+    void failReads(uint8_t page, uint8_t count);
+    void failWrites(uint8_t page, uint8_t count);
+
+    void resetCounters();
+    const SimCounters& counters() const { return stats; }
+    SimTiming timing;
+    uint8_t irqPin;             // Host pin of the IRQ line, SIM_IRQ_UNWIRED answers all pins on channel 0
+
+    // Sets the bus timing for the link, clockHz is the bit rate (I2C/SPI clock, HSU baud rate)
+    void setLink(simLinkType link, uint32_t clockHz);
+
+    // Backend of the host Adafruit_PN532
+    uint32_t command(size_t sendBytes, size_t receiveBytes);
+    bool activate(uint8_t* uid, uint8_t* uidLength, uint16_t timeout);
+    bool exchange(const uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength);
+    void startListening() { listening = true; }
+    bool irqPending() const { return listening && present; }
+    void stopListening() { listening = false; }
+
+private:
+    bool nak();
+    bool readFails(uint8_t first, uint8_t last);
+    bool tagTransaction(size_t sendBytes, size_t receiveBytes);
+
+    simTagModelType model;
+    uint8_t memory[SIM_NTAG_MAX_PAGES][4];
+    bool locked[SIM_NTAG_MAX_PAGES];
+    uint8_t uid[7];
+    uint8_t readFailPage;
+    uint8_t readFailCount;
+    uint8_t writeFailPage;
+    uint8_t writeFailCount;
+    bool present;
+    bool selected;              // Tag is in ACTIVE state, a NAK sends it back to IDLE
+    bool listening;
+    uint32_t removeCountdown;   // Tag commands until the tag leaves the field, 0 = never
+    uint32_t returnDelayMs;     // Absence of a tag lifted by the countdown, 0 = stays away
+    uint64_t returnAt;          // Simulated time the lifted tag is back, 0 = not scheduled
+    SimCounters stats;
+};
+
+// One simulated reader per multiplexer channel, the host Adafruit_PN532 talks to the selected one.
+// Without a multiplexer channel 0 stays selected.
+extern PN532Sim pn532SimChannels[SIM_MUX_CHANNELS];
+extern PN532Sim& pn532Sim;                      // Channel 0, the scale reader
+extern uint32_t simMuxSelects;                  // Control bytes written to the multiplexer
+
+PN532Sim& simSelectedReader();
+PN532Sim& simReaderForIrq(uint8_t pin);         // Reader wired to the pin, channel 0 if there is none
+
+#endif
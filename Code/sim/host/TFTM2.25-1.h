@@ -0,0 +1,6 @@
+#ifndef TFTM2_25_1_H
+#define TFTM2_25_1_H
+
+class ST7789;
+
+#endif
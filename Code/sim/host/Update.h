@@ -0,0 +1,4 @@
+#ifndef UPDATE_H
+#define UPDATE_H
+
+#endif
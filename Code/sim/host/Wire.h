@@ -0,0 +1,25 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+// I2C bus of the host build, the clock sets the link timing of the simulated readers.
+// Only the multiplexer answers raw transmissions, see PN532Sim.cpp.
+class TwoWire {
+public:
+    bool begin() { return true; }
+    void setClock(uint32_t frequency);
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    uint8_t endTransmission();
+
+private:
+    uint8_t address = 0;
+    uint8_t length = 0;
+    uint8_t data = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FREERTOSSIM_H
+#define FREERTOSSIM_H
+
+#include <stdint.h>
+
+// Single threaded FreeRTOS subset. The simulator drives the NFC task itself, so tasks
+// are never started and blocking calls only advance the simulated clock.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct SimTask* TaskHandle_t;
+typedef struct SimQueue* QueueHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE                     0
+#define pdTRUE                      1
+#define pdFAIL                      0
+#define pdPASS                      1
+#define portMAX_DELAY               0xFFFFFFFFUL
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif
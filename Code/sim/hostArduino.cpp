@@ -0,0 +1,279 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <stdarg.h>
+#include <deque>
+#include <map>
+#include <new>
+#include <vector>
+#include "PN532Sim.h"
+
+// Host implementation of the Arduino, FreeRTOS and LittleFS subset used by the NFC code
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+bool simSerialOutput = true;
+LittleFSFS LittleFS;
+
+// ##### Serial #####
+size_t HardwareSerial::write(const char* text) {
+    size_t length = strlen(text);
+    if (simSerialOutput) fwrite(text, 1, length, stdout);
+    return length;
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    return write(buffer);
+}
+
+// ##### Heap #####
+// On glibc malloc itself is replaced, which also covers operator new and ArduinoJson.
+// Other C libraries only see the C++ allocations.
+static uint32_t simAllocations = 0;
+
+uint32_t simHeapAllocations() {
+    return simAllocations;
+}
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    simAllocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    simAllocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    simAllocations++;
+    return __libc_realloc(pointer, size);
+}
+#else
+void* operator new(size_t size) {
+    simAllocations++;
+    void* pointer = malloc(size > 0 ? size : 1);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+#endif
+
+// ##### Clock #####
+static uint64_t simNow = 0;
+
+void simAdvanceMicros(uint64_t micros) {
+    simNow += micros;
+}
+
+uint64_t simMicros() {
+    return simNow;
+}
+
+unsigned long millis() {
+    return simNow / 1000;
+}
+
+unsigned long micros() {
+    return simNow;
+}
+
+void delay(uint32_t ms) {
+    simAdvanceMicros((uint64_t)ms * 1000);
+}
+
+void yield() {
+}
+
+// ##### Pins #####
+static void (*simIrqHandler)() = nullptr;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+int digitalRead(uint8_t pin) {
+    return simReaderForIrq(pin).irqPending() ? LOW : HIGH;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+    simIrqHandler = handler;
+}
+
+void detachInterrupt(uint8_t pin) {
+    simIrqHandler = nullptr;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t copy = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return length;
+}
+#endif
+
+// ##### FreeRTOS #####
+// Only the NFC task exists and it never really blocks: waiting for something that
+// cannot arrive just lets the simulated time pass.
+struct SimTask {
+    uint32_t notifications;
+};
+
+struct SimQueue {
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::deque<std::vector<uint8_t> > items;
+};
+
+static SimTask simTask = { 0 };
+
+static void simWait(TickType_t ticks) {
+    if (ticks != portMAX_DELAY) delay(ticks * portTICK_PERIOD_MS);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle) {
+    if (handle) *handle = &simTask;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    return xTaskCreate(task, name, stackSize, parameter, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+}
+
+void vTaskResume(TaskHandle_t task) {
+}
+
+void vTaskDelay(TickType_t ticks) {
+    simWait(ticks);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (task) task->notifications++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    if (task) task->notifications++;
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    // A card in the field pulls IRQ low, deliver the interrupt the task is waiting for
+    if (simTask.notifications == 0 && ticksToWait > 0 && simIrqHandler && pn532Sim.irqPending()) {
+        simIrqHandler();
+    }
+
+    uint32_t count = simTask.notifications;
+    if (count == 0) {
+        simWait(ticksToWait);
+        return 0;
+    }
+
+    simTask.notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue* queue = new SimQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    if (queue->items.size() >= queue->length) {
+        simWait(ticksToWait);
+        return pdFALSE;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.push_back(std::vector<uint8_t>(bytes, bytes + queue->itemSize));
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait) {
+    if (queue->items.empty()) {
+        simWait(ticksToWait);
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticksToWait) {
+    if (queue->items.empty()) {
+        simWait(ticksToWait);
+        return pdFALSE;
+    }
+    if (item) memcpy(item, queue->items.front().data(), queue->itemSize);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->items.size();
+}
+
+// ##### LittleFS #####
+static std::map<std::string, std::string> simFiles;
+
+size_t File::read(uint8_t* buffer, size_t length) {
+    if (!data || writing) return 0;
+    size_t available = data->size() - position;
+    if (length > available) length = available;
+    memcpy(buffer, data->data() + position, length);
+    position += length;
+    return length;
+}
+
+size_t File::write(const uint8_t* buffer, size_t length) {
+    if (!data || !writing) return 0;
+    data->append((const char*)buffer, length);
+    return length;
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+    bool writeMode = mode[0] == 'w' || mode[0] == 'a';
+    if (!writeMode && simFiles.find(path) == simFiles.end()) return File();
+
+    std::string& data = simFiles[path];
+    if (mode[0] == 'w') data.clear();
+    return File(&data, writeMode);
+}
+
+bool LittleFSFS::exists(const char* path) {
+    return simFiles.find(path) != simFiles.end();
+}
+
+bool LittleFSFS::remove(const char* path) {
+    return simFiles.erase(path) > 0;
+}
@@ -6,6 +6,8 @@
 #include "debug.h"
 #include "scale.h"
 #include "nfc.h"
+#include "nfcLatency.h"
+#include "ndef.h"
 #include <time.h>
 volatile spoolmanApiStateType spoolmanApiState = API_IDLE;
 
@@ -38,7 +40,48 @@ struct SendToApiParams {
     uint16_t weightValue;
 };
 
-JsonDocument fetchSingleSpoolInfo(int spoolId) {
+// Spool details fetched as soon as a tag names the spool, used by fetchSingleSpoolInfo
+#define SPOOL_INFO_CACHE_SIZE       4
+
+struct SpoolInfoCacheEntry {
+    int spoolId;
+    bool pending;               // Prefetch task still running
+    unsigned long fetchedAt;
+    String info;                // Filtered spool JSON
+};
+
+static SpoolInfoCacheEntry spoolInfoCache[SPOOL_INFO_CACHE_SIZE];
+static uint8_t spoolInfoCacheNext = 0;
+static SemaphoreHandle_t spoolInfoMutex = NULL;
+
+// Location updates of spools, sent by spoolLocationTask
+struct SpoolLocationUpdate {
+    uint32_t spoolId;
+    char location[SPOOLMAN_LOCATION_MAX_LENGTH];
+};
+
+static QueueHandle_t spoolLocationQueue = NULL;
+static QueueHandle_t spoolPrefetchQueue = NULL;    // Spool IDs for spoolPrefetchTask
+
+// Written spool tags, linked to their spool by spoolTagLinkTask
+struct SpoolTagLink {
+    char uid[NFC_UID_STRING_SIZE];
+    uint32_t spoolId;
+    bool updateWeight;          // Spool on the scale, not labeled in a batch
+};
+
+static QueueHandle_t spoolTagLinkQueue = NULL;
+
+// Tags of brand filament without a spool, created in Spoolman by brandFilamentTask
+struct BrandFilamentTag {
+    char uid[NFC_UID_STRING_SIZE];
+    char json[NFC_JSON_DATA_SIZE];
+};
+
+static QueueHandle_t brandFilamentQueue = NULL;
+
+static JsonDocument requestSpoolInfo(int spoolId) {
+    unsigned long start = micros();
     HTTPClient http;
     String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId;
 
@@ -103,9 +146,120 @@ JsonDocument fetchSingleSpoolInfo(int spoolId) {
     }
 
     http.end();
+    nfcLatencyRecord(NFC_PHASE_SPOOLMAN, micros() - start);
     return filteredDoc;
 }
 
+// Call with spoolInfoMutex taken
+static SpoolInfoCacheEntry* findSpoolInfo(int spoolId) {
+    for (uint8_t i = 0; i < SPOOL_INFO_CACHE_SIZE; i++) {
+        if (spoolInfoCache[i].spoolId == spoolId) return &spoolInfoCache[i];
+    }
+    return NULL;
+}
+
+// Call with spoolInfoMutex taken
+static SpoolInfoCacheEntry* addSpoolInfo(int spoolId) {
+    SpoolInfoCacheEntry* entry = &spoolInfoCache[spoolInfoCacheNext];
+    spoolInfoCacheNext = (spoolInfoCacheNext + 1) % SPOOL_INFO_CACHE_SIZE;
+    entry->spoolId = spoolId;
+    entry->pending = false;
+    entry->fetchedAt = 0;
+    entry->info = "";
+    return entry;
+}
+
+static void storeSpoolInfo(int spoolId, const JsonDocument& info) {
+    if (spoolInfoMutex == NULL) return;
+
+    xSemaphoreTake(spoolInfoMutex, portMAX_DELAY);
+    SpoolInfoCacheEntry* entry = findSpoolInfo(spoolId);
+    if (info.isNull()) {
+        // Failed requests are not cached, the next use asks Spoolman again
+        if (entry != NULL) entry->spoolId = 0;
+    } else {
+        if (entry == NULL) entry = addSpoolInfo(spoolId);
+        entry->pending = false;
+        entry->fetchedAt = millis();
+        entry->info = "";
+        serializeJson(info, entry->info);
+    }
+    xSemaphoreGive(spoolInfoMutex);
+}
+
+void invalidateSpoolInfo() {
+    if (spoolInfoMutex == NULL) return;
+
+    xSemaphoreTake(spoolInfoMutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < SPOOL_INFO_CACHE_SIZE; i++) {
+        if (!spoolInfoCache[i].pending) spoolInfoCache[i].spoolId = 0;
+    }
+    xSemaphoreGive(spoolInfoMutex);
+}
+
+JsonDocument fetchSingleSpoolInfo(int spoolId) {
+    JsonDocument info;
+
+    // Usually prefetched when the tag was read, a running prefetch is waited for instead of asking twice
+    unsigned long waitStart = millis();
+    while (spoolInfoMutex != NULL) {
+        xSemaphoreTake(spoolInfoMutex, portMAX_DELAY);
+        SpoolInfoCacheEntry* entry = findSpoolInfo(spoolId);
+        bool pending = entry != NULL && entry->pending;
+        bool cached = entry != NULL && !pending && millis() - entry->fetchedAt < SPOOLMAN_SPOOL_INFO_MAX_AGE;
+        if (cached) deserializeJson(info, entry->info);
+        xSemaphoreGive(spoolInfoMutex);
+
+        if (cached) {
+            Serial.printf("Spool-Daten %d aus dem Cache\n", spoolId);
+            return info;
+        }
+        if (!pending || millis() - waitStart >= SPOOLMAN_SPOOL_INFO_WAIT) break;
+        vTaskDelay(50 / portTICK_PERIOD_MS);
+    }
+
+    info = requestSpoolInfo(spoolId);
+    storeSpoolInfo(spoolId, info);
+    return info;
+}
+
+// Fetches the spools prefetchSpoolInfo queued, one request after the other
+static void spoolPrefetchTask(void *parameter) {
+    int spoolId;
+
+    while (true) {
+        xQueueReceive(spoolPrefetchQueue, &spoolId, portMAX_DELAY);
+
+        JsonDocument info = requestSpoolInfo(spoolId);
+        storeSpoolInfo(spoolId, info);
+        if (!info.isNull()) {
+            sendSpoolInfo(spoolId, info);
+        }
+    }
+}
+
+void prefetchSpoolInfo(int spoolId) {
+    if (spoolId <= 0 || !spoolmanConnected || spoolInfoMutex == NULL) return;
+
+    xSemaphoreTake(spoolInfoMutex, portMAX_DELAY);
+    SpoolInfoCacheEntry* entry = findSpoolInfo(spoolId);
+    bool needed = entry == NULL || (!entry->pending && millis() - entry->fetchedAt >= SPOOLMAN_SPOOL_INFO_MAX_AGE);
+    if (needed) {
+        if (entry == NULL) entry = addSpoolInfo(spoolId);
+        entry->pending = true;
+    }
+    xSemaphoreGive(spoolInfoMutex);
+
+    if (!needed) return;
+
+    // Called by the NFC task, so only queued. The worker marks the entry as fetched.
+    Serial.printf("Prefetch Spool-Daten %d\n", spoolId);
+    if (spoolPrefetchQueue == NULL || xQueueSend(spoolPrefetchQueue, &spoolId, 0) != pdTRUE) {
+        Serial.println("Fehler: Warteschlange für Spool-Daten ist voll.");
+        storeSpoolInfo(spoolId, JsonDocument());
+    }
+}
+
 void sendToApi(void *parameter) {
     HEAP_DEBUG_MESSAGE("sendToApi begin");
 
@@ -185,6 +339,9 @@ void sendToApi(void *parameter) {
     if (success) {
         Serial.println("Spoolman Abfrage erfolgreich");
 
+        // Bambu settings of the filament changed, prefetched spool details are outdated
+        if (requestType == API_REQUEST_BAMBU_UPDATE) invalidateSpoolInfo();
+
         // Restgewicht der Spule auslesen
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, responsePayload);
@@ -393,7 +550,7 @@ void sendToApi(void *parameter) {
         }
         Serial.println("Fehler beim Senden an Spoolman! HTTP Code: " + String(httpCode));
         vTaskDelay(2000 / portTICK_PERIOD_MS);
-        nfcReaderState = NFC_IDLE; // Reset NFC state to allow retry
+        nfcSendCommand(NFC_CMD_SCAN); // Process the tag again to allow retry
     }
 
     vTaskDelay(50 / portTICK_PERIOD_MS);
@@ -405,30 +562,12 @@ void sendToApi(void *parameter) {
     vTaskDelete(NULL);
 }
 
-bool updateSpoolTagId(String uidString, const char* payload) {
+bool updateSpoolTagId(String uidString, uint32_t spoolId, bool updateWeight) {
     oledShowProgressBar(2, 3, "Write Tag", "Update Spoolman");
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
-    
-    if (error) {
-        Serial.print("Fehler beim JSON-Parsing: ");
-        Serial.println(error.c_str());
-        return false;
-    }
-    
-    // Überprüfe, ob die erforderlichen Felder vorhanden sind
-    if (!doc["sm_id"].is<String>() || doc["sm_id"].as<String>() == "") {
-        Serial.println("Keine Spoolman-ID gefunden.");
-        return false;
-    }
-
-    String spoolId = doc["sm_id"].as<String>();
     String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId;
     Serial.print("Update Spule mit URL: ");
     Serial.println(spoolsUrl);
-    
-    doc.clear();
 
     // Update Payload erstellen
     JsonDocument updateDoc;
@@ -450,8 +589,8 @@ bool updateSpoolTagId(String uidString, const char* payload) {
     params->updatePayload = updatePayload;
     
     // Add weight update parameters for sequential execution
-    params->triggerWeightUpdate = (weight > 10);
-    params->spoolIdForWeight = spoolId;
+    params->triggerWeightUpdate = updateWeight && (weight > 10);
+    params->spoolIdForWeight = String(spoolId);
     params->weightValue = weight;
 
     // Erstelle die Task mit erhöhter Stackgröße für zusätzliche HTTP-Anfrage
@@ -515,52 +654,99 @@ uint8_t updateSpoolWeight(String spoolId, uint16_t weight) {
     return 1;
 }
 
-uint8_t updateSpoolLocation(String spoolId, String location){
-    HEAP_DEBUG_MESSAGE("updateSpoolLocation begin");
+// Links the queued tags, updateSpoolTagId sends the weight after the link when the spool is on the scale
+static void spoolTagLinkTask(void *parameter) {
+    SpoolTagLink link;
 
-    oledShowProgressBar(3, octoEnabled?5:4, "Loc. Tag", "Spoolman update");
+    while (true) {
+        xQueueReceive(spoolTagLinkQueue, &link, portMAX_DELAY);
+        updateSpoolTagId(String(link.uid), link.spoolId, link.updateWeight);
+    }
+}
 
-    String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId;
-    Serial.print("Update Spule mit URL: ");
-    Serial.println(spoolsUrl);
+// Sends one queued location update over the connection of the worker
+static bool patchSpoolLocation(HTTPClient& http, WiFiClient& client, const SpoolLocationUpdate& update) {
+    String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + update.spoolId;
 
-    // Update Payload erstellen
     JsonDocument updateDoc;
-    updateDoc["location"] = location;
-    
+    updateDoc["location"] = update.location;
     String updatePayload;
     serializeJson(updateDoc, updatePayload);
-    Serial.print("Update Payload: ");
-    Serial.println(updatePayload);
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return 0;
+    int httpCode = -1;
+    for (uint8_t attempt = 1; attempt <= 2; attempt++) {
+        http.begin(client, spoolsUrl);
+        http.addHeader("Content-Type", "application/json");
+        httpCode = http.PATCH(updatePayload);
+        // The response has to be read completely, otherwise the connection cannot be reused
+        if (httpCode > 0) http.getString();
+        http.end();
+
+        if (httpCode == HTTP_CODE_OK) return true;
+        // Spoolman may have closed the kept connection, the second attempt opens a new one
+        if (httpCode > 0) break;
+        client.stop();
     }
-    params->requestType = API_REQUEST_SPOOL_LOCATION_UPDATE;
-    params->httpType = "PATCH";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = updatePayload;
 
+    Serial.printf("Lagerort von Spule %lu nicht aktualisiert, HTTP Code: %d\n", (unsigned long)update.spoolId, httpCode);
+    return false;
+}
+
+// Works off the location queue. Everything queued while a request runs is sent right after it
+// over the same keep-alive connection instead of one task and connection per spool.
+static void spoolLocationTask(void *parameter) {
+    SpoolLocationUpdate update;
 
-    if(apiTask == nullptr){
-        // Erstelle die Task
-        BaseType_t result = xTaskCreate(
-            sendToApi,                // Task-Funktion
-            "SendToApiTask",          // Task-Name
-            6144,                     // Stackgröße in Bytes
-            (void*)params,            // Parameter
-            0,                        // Priorität
-            apiTask                   // Task-Handle
-        );
-    }else{
-        Serial.println("Not spawning new task, API still active!");
+    while (true) {
+        xQueueReceive(spoolLocationQueue, &update, portMAX_DELAY);
+
+        // Wait until API is IDLE
+        while (spoolmanApiState != API_IDLE) {
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+        }
+        spoolmanApiState = API_TRANSMITTING;
+        HEAP_DEBUG_MESSAGE("spoolLocationTask begin");
+
+        WiFiClient client;
+        HTTPClient http;
+        http.setReuse(true);
+        http.setTimeout(10000);
+
+        uint16_t updated = 0;
+        uint16_t failed = 0;
+        unsigned long start = millis();
+        do {
+            if (patchSpoolLocation(http, client, update)) updated++;
+            else failed++;
+        } while (xQueueReceive(spoolLocationQueue, &update, 0) == pdTRUE);
+        client.stop();
+
+        Serial.printf("Lagerorte aktualisiert: %u, Fehler: %u, Dauer: %lu ms\n", updated, failed, millis() - start);
+        if (failed > 0) oledShowProgressBar(1, 1, "Failure!", "Spoolman update");
+
+        HEAP_DEBUG_MESSAGE("spoolLocationTask end");
+        spoolmanApiState = API_IDLE;
     }
+}
 
-    updateDoc.clear();
+// Queues the update, the NFC task goes on with the next spool while the worker sends it
+uint8_t updateSpoolLocation(uint32_t spoolId, const char* location){
+    if (spoolLocationQueue == NULL) {
+        Serial.println("Fehler: Spoolman nicht initialisiert.");
+        return 0;
+    }
+
+    SpoolLocationUpdate update;
+    update.spoolId = spoolId;
+    strlcpy(update.location, location, sizeof(update.location));
+
+    Serial.printf("Lagerort von Spule %lu: %s\n", (unsigned long)spoolId, update.location);
+    if (xQueueSend(spoolLocationQueue, &update, 0) != pdTRUE) {
+        Serial.println("Fehler: Warteschlange für Lagerorte ist voll.");
+        oledShowProgressBar(1, 1, "Failure!", "Location queue full");
+        return 0;
+    }
 
-    HEAP_DEBUG_MESSAGE("updateSpoolLocation end");
     return 1;
 }
 
@@ -1011,7 +1197,7 @@ uint16_t createSpool(uint16_t vendorId, uint16_t filamentId, JsonDocument& paylo
     // Check if spool creation was successful
     if (createdSpoolId == 0) {
         Serial.println("ERROR: Spool creation failed");
-        nfcReaderState = NFC_IDLE; // Reset NFC state
+        nfcSendCommand(NFC_CMD_SCAN); // Process the tag again to allow retry
         return 0;
     }
 
@@ -1031,8 +1217,6 @@ uint16_t createSpool(uint16_t vendorId, uint16_t filamentId, JsonDocument& paylo
     Serial.println(payloadString);
     
     optimizedPayload.clear();
-    
-    nfcReaderState = NFC_IDLE;
 
     // Delay for Display Bar
     vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -1065,6 +1249,36 @@ bool createBrandFilament(JsonDocument& payload, String uidString) {
     return true;
 }
 
+// Creates the queued brand filament spools, the tag is written once Spoolman returned the spool ID
+static void brandFilamentTask(void *parameter) {
+    static BrandFilamentTag tag;
+
+    while (true) {
+        xQueueReceive(brandFilamentQueue, &tag, portMAX_DELAY);
+
+        JsonDocument payload;
+        if (deserializeJson(payload, tag.json)) {
+            Serial.println("Fehler: JSON des Brand-Filament-Tags ungültig");
+            continue;
+        }
+        createBrandFilament(payload, String(tag.uid));
+    }
+}
+
+bool queueBrandFilament(const char* json, const char* uidString) {
+    // Only the NFC task queues, the item is copied from here
+    static BrandFilamentTag tag;
+    if (strlen(json) >= sizeof(tag.json)) return false;
+
+    strlcpy(tag.uid, uidString, sizeof(tag.uid));
+    strlcpy(tag.json, json, sizeof(tag.json));
+    if (brandFilamentQueue == NULL || xQueueSend(brandFilamentQueue, &tag, 0) != pdTRUE) {
+        Serial.println("Fehler: Warteschlange für Brand-Filament-Tags ist voll.");
+        return false;
+    }
+    return true;
+}
+
 // #### Spoolman init
 bool checkSpoolmanExtraFields() {
     // Only check extra fields if they have not been checked before
@@ -1319,8 +1533,69 @@ String loadSpoolmanUrl() {
     return spoolmanUrl;
 }
 
+// Hands read spools to the prefetch and freshly written spool tags to the link worker, nothing here waits for Spoolman
+static void onNfcEvent(const NfcEvent& event) {
+    if (event.reader != NFC_SCALE_READER) return;
+
+    // Spool details are fetched while the weight settles, autoSetSpool finds them in the cache.
+    // sm_id is looked up in place, the NFC task must not allocate on a read.
+    if (event.type == NFC_EVENT_READ_DONE && event.success) {
+        const char* value;
+        size_t valueLength;
+        if (jsonFindValue(event.payload, strlen(event.payload), "sm_id", &value, &valueLength)) {
+            prefetchSpoolInfo(jsonValueToUint(value, valueLength));
+        }
+        return;
+    }
+
+    if (event.type != NFC_EVENT_WRITE_DONE || !event.success || !event.isSpoolTag) return;
+
+    const char* value;
+    size_t valueLength;
+    SpoolTagLink link;
+    link.spoolId = jsonFindValue(event.payload, strlen(event.payload), "sm_id", &value, &valueLength)
+        ? jsonValueToUint(value, valueLength) : 0;
+    if (link.spoolId == 0) {
+        Serial.println("Keine Spoolman-ID gefunden.");
+        return;
+    }
+    strlcpy(link.uid, event.uid, sizeof(link.uid));
+    // Spools labeled in a batch are not the one on the scale
+    link.updateWeight = event.batchTotal == 0;
+
+    // Sent by spoolTagLinkTask, the NFC task goes on with the next tag
+    if (spoolTagLinkQueue == NULL || xQueueSend(spoolTagLinkQueue, &link, 0) != pdTRUE) {
+        Serial.println("Fehler: Warteschlange für Tag-Verknüpfungen ist voll.");
+    }
+}
+
 bool initSpoolman() {
     oledShowProgressBar(3, 7, DISPLAY_BOOT_TEXT, "Spoolman init");
+    // Only once, initSpoolman also runs on reconnect
+    if (spoolInfoMutex == NULL) {
+        spoolInfoMutex = xSemaphoreCreateMutex();
+        spoolLocationQueue = xQueueCreate(SPOOLMAN_LOCATION_QUEUE_SIZE, sizeof(SpoolLocationUpdate));
+        if (spoolLocationQueue == NULL ||
+            xTaskCreate(spoolLocationTask, "SpoolLocation", 6144, NULL, 0, NULL) != pdPASS) {
+            Serial.println("Fehler beim Erstellen des Lagerort-Tasks");
+        }
+        spoolPrefetchQueue = xQueueCreate(SPOOLMAN_PREFETCH_QUEUE_SIZE, sizeof(int));
+        if (spoolPrefetchQueue == NULL ||
+            xTaskCreate(spoolPrefetchTask, "SpoolPrefetch", 6144, NULL, 0, NULL) != pdPASS) {
+            Serial.println("Fehler beim Erstellen des Prefetch-Tasks");
+        }
+        spoolTagLinkQueue = xQueueCreate(SPOOLMAN_TAG_LINK_QUEUE_SIZE, sizeof(SpoolTagLink));
+        if (spoolTagLinkQueue == NULL ||
+            xTaskCreate(spoolTagLinkTask, "SpoolTagLink", 4096, NULL, 0, NULL) != pdPASS) {
+            Serial.println("Fehler beim Erstellen des Tag-Verknüpfungs-Tasks");
+        }
+        brandFilamentQueue = xQueueCreate(SPOOLMAN_BRAND_FILAMENT_QUEUE_SIZE, sizeof(BrandFilamentTag));
+        if (brandFilamentQueue == NULL ||
+            xTaskCreate(brandFilamentTask, "BrandFilament", 6144, NULL, 0, NULL) != pdPASS) {
+            Serial.println("Fehler beim Erstellen des Brand-Filament-Tasks");
+        }
+        nfcSubscribe(onNfcEvent);
+    }
     spoolmanUrl = loadSpoolmanUrl();
     
     bool success = checkSpoolmanInstance();
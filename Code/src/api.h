@@ -40,12 +40,15 @@ bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octoWh, const
 String loadSpoolmanUrl(); // Neue Funktion zum Laden der URL
 bool checkSpoolmanExtraFields(); // Neue Funktion zum Überprüfen der Extrafelder
 JsonDocument fetchSingleSpoolInfo(int spoolId); // API-Funktion für die Webseite
-bool updateSpoolTagId(String uidString, const char* payload); // Neue Funktion zum Aktualisieren eines Spools
+void prefetchSpoolInfo(int spoolId); // Holt die Spool-Daten im Hintergrund für fetchSingleSpoolInfo
+void invalidateSpoolInfo();
+bool updateSpoolTagId(String uidString, uint32_t spoolId, bool updateWeight = true); // Links the tag to the spool, the weight follows
 uint8_t updateSpoolWeight(String spoolId, uint16_t weight); // Neue Funktion zum Aktualisieren des Gewichts
-uint8_t updateSpoolLocation(String spoolId, String location);
+uint8_t updateSpoolLocation(uint32_t spoolId, const char* location); // Queues the update, no heap allocations
 bool initSpoolman(); // Neue Funktion zum Initialisieren von Spoolman
 bool updateSpoolBambuData(String payload); // Neue Funktion zum Aktualisieren der Bambu-Daten
 bool updateSpoolOcto(int spoolId); // Neue Funktion zum Aktualisieren der Octo-Daten
 bool createBrandFilament(JsonDocument& payload, String uidString);
+bool queueBrandFilament(const char* json, const char* uidString); // Copies the tag, createBrandFilament runs in a worker task
 
 #endif
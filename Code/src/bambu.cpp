@@ -22,6 +22,7 @@ bool bambuDisabled = false;
 
 bool bambu_connected = false;
 uint16_t autoSetToBambuSpoolId = 0;
+volatile bool pauseBambuMqttTask = false;
 
 BambuCredentials bambuCredentials;
 
@@ -38,6 +38,7 @@ extern int ams_count;
 extern AMSData ams_data[MAX_AMS];
 //extern bool autoSendToBambu;
 extern uint16_t autoSetToBambuSpoolId;
+extern volatile bool pauseBambuMqttTask;
 extern bool bambuDisabled;
 extern BambuCredentials bambuCredentials;
 
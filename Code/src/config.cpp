@@ -2,12 +2,31 @@
 
 // ################### Config Bereich Start
 // ***** PN532 (RFID)
-//#define PN532_SCK   18
-//#define PN532_MOSI  23
-//#define PN532_SS    5
-//#define PN532_MISO  19
+// Link to the PN532, set the mode switches of the module to match:
+// PN532_TRANSPORT_I2C, PN532_TRANSPORT_SPI (shares SCK/MOSI with the display) or PN532_TRANSPORT_HSU (Serial1)
+const pn532TransportType PN532_TRANSPORT = PN532_TRANSPORT_I2C;
+// The PN532 supports up to 400 kHz, 100 kHz is the safe value for long wires and weak pull-ups
+const uint32_t PN532_I2C_CLOCK = 100000;
+// SPI runs at the 1 MHz of the driver, the free I2C pins take SS and MISO
+const uint8_t PN532_SS = 9;
+const int8_t PN532_SPI_MISO = 8;
+// HSU at 115200 baud, PN532 modules have TXD/RXD on the SDA/SCL header pins
+const int8_t PN532_HSU_RX = 8;
+const int8_t PN532_HSU_TX = 9;
 const uint8_t PN532_IRQ = 20;
 const uint8_t PN532_RESET = 21;
+// IRQ line wakes the reader task on card arrival, false falls back to polling
+const bool PN532_IRQ_ENABLED = true;
+// Empty scale: the reader is polled every NFC_IDLE_POLL_INTERVAL with the RF field off in between,
+// false keeps the field on and polls (or listens) at full rate all the time
+const bool NFC_DUTY_CYCLE_ENABLED = true;
+// Readers, the first one is the scale reader. Shelf readers need PN532_TRANSPORT_I2C and a TCA9548A,
+// e.g. { { 0, PN532_IRQ }, { 1, 3 }, { 2, 4 } } for two shelf readers on channels 1 and 2
+const uint8_t NFC_MUX_ADDRESS = 0x70;
+const NfcReaderConfig NFC_READERS[] = {
+    { NFC_MUX_NONE, PN532_IRQ },
+};
+const uint8_t NFC_READER_COUNT = sizeof(NFC_READERS) / sizeof(NFC_READERS[0]);
 // ***** PN532
 
 // ***** HX711 (Waage)
@@ -52,8 +71,6 @@ const char* apiUrl = "/api/v1";
 uint8_t rfidTaskCore = 1;
 uint8_t rfidTaskPrio = 1;
 
-uint8_t rfidWriteTaskPrio = 1;
-
 uint8_t mqttTaskCore = 1;
 uint8_t mqttTaskPrio = 1;
 
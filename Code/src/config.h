@@ -36,6 +36,29 @@
 #define WIFI_CHECK_INTERVAL                 60000U
 #define DISPLAY_UPDATE_INTERVAL             1000U
 #define SPOOLMAN_HEALTHCHECK_INTERVAL       60000U
+#define SPOOLMAN_SPOOL_INFO_MAX_AGE         300000U // Prefetched spool details are used this long
+#define SPOOLMAN_SPOOL_INFO_WAIT            10000U  // Max. wait for a prefetch that is still running
+#define SPOOLMAN_LOCATION_QUEUE_SIZE        32U     // Location updates waiting to be sent to Spoolman
+#define SPOOLMAN_LOCATION_MAX_LENGTH        48U     // Longer location names are cut, including the terminator
+#define SPOOLMAN_PREFETCH_QUEUE_SIZE        4U      // Read spools waiting for the prefetch of their details
+#define SPOOLMAN_TAG_LINK_QUEUE_SIZE        4U      // Written spool tags waiting to be linked to their spool
+#define SPOOLMAN_BRAND_FILAMENT_QUEUE_SIZE  2U      // Brand filament tags waiting for their spool to be created
+#define WEBSITE_NFC_QUEUE_SIZE              16U     // NFC events waiting to be pushed to the web clients
+#define NFC_COMMAND_SEND_TIMEOUT            1000U   // Max. wait for room in the command queue for commands that must not be dropped
+#define NFC_IRQ_WAIT_TIMEOUT                1000U   // Max. wait for a card interrupt before the scan loop runs again
+#define NFC_PRESENCE_CHECK_INTERVAL         50U     // Pause between presence checks of a tag that was already processed
+#define NFC_PRESENCE_TIMEOUT                25U     // Select timeout of a presence check, two misses in a row count as removal
+#define NFC_BATCH_MAX_TAGS                  50U     // Max. payloads of one batch write
+#define NFC_WRITE_RESUME_TIMEOUT            30000U  // An interrupted write continues if the same tag is back within this time
+#define NFC_WRITE_VERIFY_ROUNDS             2U      // Rewrites of pages that differ in the read-back after a write
+#define NFC_RELOCATION_SESSION_TIMEOUT      120000U // A relocation session ends this long after its last scan
+#define NFC_IDLE_POLL_INTERVAL              500U    // Duty cycle: pause between polls while the scale is empty, RF field off
+#define NFC_IDLE_POLL_TIMEOUT               50U     // Duty cycle: InListPassiveTarget timeout of one poll
+#define NFC_ACTIVE_HOLD_TIME                30000U  // Fast polling continues this long after the last tag, command or weight step
+#define NFC_LOAD_THRESHOLD                  10      // Weight in g from which the scale counts as loaded
+#define NFC_WAKE_WEIGHT_STEP                10.0f   // Change between two raw readings in g that switches to fast polling
+#define NFC_MAX_READERS                     8       // Channels of a TCA9548A
+#define NFC_READER_ROUND_INTERVAL           50U     // Several readers: pause after each round over all of them
 
 // TFT Display Pins
 extern const uint8_t TFT_CS;
@@ -45,8 +68,35 @@ extern const uint8_t TFT_SCK;
 extern const uint8_t TFT_MOSI;
 extern const uint8_t TFT_BLK;
 
+// Link between the ESP32 and the PN532, selected in config.cpp
+typedef enum {
+    PN532_TRANSPORT_I2C,
+    PN532_TRANSPORT_SPI,
+    PN532_TRANSPORT_HSU
+} pn532TransportType;
+
+extern const pn532TransportType PN532_TRANSPORT;
+extern const uint32_t PN532_I2C_CLOCK;
+extern const uint8_t PN532_SS;
+extern const int8_t PN532_SPI_MISO;
+extern const int8_t PN532_HSU_RX;
+extern const int8_t PN532_HSU_TX;
 extern const uint8_t PN532_IRQ;
 extern const uint8_t PN532_RESET;
+extern const bool PN532_IRQ_ENABLED;
+extern const bool NFC_DUTY_CYCLE_ENABLED;
+
+// One PN532 on the I2C bus. With more than one they all answer at the same address and sit behind
+// a TCA9548A multiplexer; every reader needs its own IRQ line, the driver waits on it for responses.
+#define NFC_MUX_NONE                -1      // Reader directly on the bus
+typedef struct {
+    int8_t muxChannel;
+    uint8_t irqPin;
+} NfcReaderConfig;
+
+extern const uint8_t NFC_MUX_ADDRESS;
+extern const NfcReaderConfig NFC_READERS[];
+extern const uint8_t NFC_READER_COUNT;
 
 extern const uint8_t LOADCELL_DOUT_PIN;
 extern const uint8_t LOADCELL_SCK_PIN;
@@ -78,8 +128,6 @@ extern const unsigned char icon_loading[];
 extern uint8_t rfidTaskCore;
 extern uint8_t rfidTaskPrio;
 
-extern uint8_t rfidWriteTaskPrio;
-
 extern uint8_t mqttTaskCore;
 extern uint8_t mqttTaskPrio;
 
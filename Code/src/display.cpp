@@ -25,8 +25,8 @@ uint16_t hexToRGB565(String hex) {
 }
 
 void setupDisplay() {
-    // Initialize SPI with specific pins for ESP32
-    SPI.begin(TFT_SCK, -1, TFT_MOSI, TFT_CS);
+    // Initialize SPI with specific pins for ESP32, a PN532 on the same bus needs MISO
+    SPI.begin(TFT_SCK, PN532_TRANSPORT == PN532_TRANSPORT_SPI ? PN532_SPI_MISO : -1, TFT_MOSI, TFT_CS);
 
     // Set backlight pin
     pinMode(TFT_BLK, OUTPUT);
@@ -17,6 +17,20 @@ bool mainTaskWasPaused = 0;
 uint8_t scaleTareCounter = 0;
 bool touchSensorConnected = false;
 bool booting = true;
+bool tagProcessed = false;
+volatile nfcReaderStateType nfcState = NFC_IDLE; // Reader state as reported by the NFC task
+
+// Keeps the loop in sync with the NFC task
+static void onNfcEvent(const NfcEvent& event) {
+  // Shelf readers only relocate spools, the scale follows its own reader
+  if (event.reader != NFC_SCALE_READER) return;
+  nfcState = event.state;
+
+  // Set the current tag as not processed
+  if (event.type == NFC_EVENT_TAG_ARRIVED && event.state == NFC_READING) {
+    tagProcessed = false;
+  }
+}
 
 // ##### SETUP #####
 void setup() {
@@ -47,6 +61,7 @@ void setup() {
   setupMqtt();
 
   // NFC Reader
+  nfcSubscribe(onNfcEvent);
   startNfc();
 
   // Touch Sensor
@@ -135,7 +150,7 @@ void loop() {
   }
 
   // Wenn Bambu auto set Spool aktiv
-  if (bambuCredentials.autosend_enable && autoSetToBambuSpoolId > 0 && !nfcWriteInProgress) 
+  if (bambuCredentials.autosend_enable && autoSetToBambuSpoolId > 0 && nfcState != NFC_WRITING) 
   {
     if (!bambuDisabled && !bambu_connected) 
     {
@@ -144,7 +159,7 @@ void loop() {
 
     if (intervalElapsed(currentMillis, lastAutoSetBambuAmsTime, autoSetBambuAmsInterval)) 
     {
-      if (nfcReaderState == NFC_IDLE)
+      if (nfcState == NFC_IDLE)
       {
         lastAutoSetBambuAmsTime = currentMillis;
         oledShowMessage("Auto Set         " + String(bambuCredentials.autosend_time - autoAmsCounter) + "s");
@@ -154,7 +169,7 @@ void loop() {
         {
           autoSetToBambuSpoolId = 0;
           autoAmsCounter = 0;
-          if (!nfcWriteInProgress) {
+          if (nfcState != NFC_WRITING) {
             oledShowWeight(weight);
           }
         }
@@ -179,11 +194,11 @@ void loop() {
   {
     // Ausgabe der Waage auf Display
     // Block weight display during NFC write operations
-    if(pauseMainTask == 0 && !nfcWriteInProgress)
+    if(pauseMainTask == 0 && nfcState != NFC_WRITING)
     {
       // Use filtered weight for smooth display, but still check API weight for significant changes
       int16_t displayWeight = getFilteredDisplayWeight();
-      if (mainTaskWasPaused || (weight != lastWeight && nfcReaderState == NFC_IDLE && (!bambuCredentials.autosend_enable || autoSetToBambuSpoolId == 0)))
+      if (mainTaskWasPaused || (weight != lastWeight && nfcState == NFC_IDLE && (!bambuCredentials.autosend_enable || autoSetToBambuSpoolId == 0)))
       {
         (displayWeight < 2) ? ((displayWeight < -2) ? oledShowMessage("!! -0") : oledShowWeight(0)) : oledShowWeight(displayWeight);
       }
@@ -196,7 +211,7 @@ void loop() {
 
 
     // Wenn Timer abgelaufen und nicht gerade ein RFID-Tag geschrieben wird
-    if (currentMillis - lastWeightReadTime >= weightReadInterval && nfcReaderState < NFC_WRITING)
+    if (currentMillis - lastWeightReadTime >= weightReadInterval && nfcState < NFC_WRITING)
     {
       lastWeightReadTime = currentMillis;
 
@@ -213,7 +228,7 @@ void loop() {
     }
 
     // reset weight counter after writing tag
-    if (currentMillis - lastWeightReadTime >= weightReadInterval && nfcReaderState != NFC_IDLE && nfcReaderState != NFC_READ_SUCCESS)
+    if (currentMillis - lastWeightReadTime >= weightReadInterval && nfcState != NFC_IDLE && nfcState != NFC_READ_SUCCESS)
     {
       weightCounterToApi = 0;
     }
@@ -221,23 +236,23 @@ void loop() {
     lastWeight = weight;
 
     // Wenn ein Tag mit SM id erkannte wurde und der Waage Counter anspricht an SM Senden
-    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_READ_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
+    if (activeSpoolId != 0 && weightCounterToApi > 3 && weightSend == 0 && nfcState == NFC_READ_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
     {
       // set the current tag as processed to prevent it beeing processed again
       tagProcessed = true;
 
-      if (updateSpoolWeight(activeSpoolId, weight)) 
+      if (updateSpoolWeight(String(activeSpoolId), weight)) 
       {
         weightSend = 1;
         
         // Set Bambu spool ID for auto-send if enabled
         if (bambuCredentials.autosend_enable) 
         {
-          autoSetToBambuSpoolId = activeSpoolId.toInt();
+          autoSetToBambuSpoolId = activeSpoolId;
         }
         if (octoEnabled) 
         {
-          updateOctoSpoolId = activeSpoolId.toInt();
+          updateOctoSpoolId = activeSpoolId;
         }
       }
       else
@@ -248,12 +263,12 @@ void loop() {
     }
 
     // Handle successful tag write: Send weight to Spoolman but NEVER auto-send to Bambu
-    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_WRITE_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
+    if (activeSpoolId != 0 && weightCounterToApi > 3 && weightSend == 0 && nfcState == NFC_WRITE_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
     {
       // set the current tag as processed to prevent it beeing processed again
       tagProcessed = true;
 
-      if (updateSpoolWeight(activeSpoolId, weight)) 
+      if (updateSpoolWeight(String(activeSpoolId), weight)) 
       {
         weightSend = 1;
         Serial.println("Tag written: Weight sent to Spoolman, but NO auto-send to Bambu");
@@ -0,0 +1,519 @@
+#include "ndef.h"
+#include <string.h>
+#include <stdio.h>
+
+bool ndefFindMessage(const uint8_t* data, size_t length, size_t* messageOffset, uint16_t* messageLength) {
+    size_t offset = 0;
+
+    while (offset < length) {
+        uint8_t tlvType = data[offset];
+
+        if (tlvType == NDEF_TLV_NULL) {
+            offset++;
+            continue;
+        }
+        if (tlvType == NDEF_TLV_TERMINATOR || offset + 1 >= length) {
+            return false;
+        }
+
+        // Length is either one byte or 0xFF followed by two bytes
+        uint16_t tlvLength = data[offset + 1];
+        size_t valueOffset = offset + 2;
+        if (tlvLength == 0xFF) {
+            if (offset + 3 >= length) return false;
+            tlvLength = (data[offset + 2] << 8) | data[offset + 3];
+            valueOffset = offset + 4;
+        }
+
+        if (tlvType == NDEF_TLV_MESSAGE) {
+            *messageOffset = valueOffset;
+            *messageLength = tlvLength;
+            return true;
+        }
+
+        // Lock Control, Memory Control and proprietary TLVs are skipped
+        offset = valueOffset + tlvLength;
+    }
+
+    return false;
+}
+
+bool ndefNextRecord(const uint8_t* message, size_t messageLength, size_t* offset, NdefRecordView* record) {
+    size_t pos = *offset;
+
+    if (pos + 3 > messageLength) return false;
+
+    uint8_t header = message[pos++];
+    uint8_t typeLength = message[pos++];
+    uint32_t payloadLength;
+
+    if (header & NDEF_FLAG_SR) {
+        payloadLength = message[pos++];
+    } else {
+        if (pos + 4 > messageLength) return false;
+        payloadLength = ((uint32_t)message[pos] << 24) | ((uint32_t)message[pos + 1] << 16) |
+                        ((uint32_t)message[pos + 2] << 8) | message[pos + 3];
+        pos += 4;
+    }
+
+    uint8_t idLength = 0;
+    if (header & NDEF_FLAG_IL) {
+        if (pos >= messageLength) return false;
+        idLength = message[pos++];
+    }
+
+    // Type and ID have to be complete, the payload may be cut off by a partial read
+    if (pos + typeLength + idLength > messageLength) return false;
+
+    record->header = header;
+    record->type = &message[pos];
+    record->typeLength = typeLength;
+    pos += typeLength + idLength;
+
+    record->payload = &message[pos];
+    record->payloadLength = payloadLength;
+    record->availableLength = (pos + payloadLength <= messageLength) ? payloadLength : messageLength - pos;
+
+    *offset = pos + payloadLength;
+    return true;
+}
+
+static bool isMimeRecord(const NdefRecordView* record, const char* mimeType) {
+    size_t mimeLength = strlen(mimeType);
+    return (record->header & NDEF_TNF_MASK) == NDEF_TNF_MIME_MEDIA &&
+           record->typeLength == mimeLength &&
+           memcmp(record->type, mimeType, mimeLength) == 0;
+}
+
+static bool isJsonRecord(const NdefRecordView* record) {
+    if (isMimeRecord(record, NDEF_MIME_JSON)) return true;
+    return record->availableLength > 0 && record->payload[0] == '{';
+}
+
+// Walks the records of the message, mimeType NULL selects the JSON record
+static bool findRecord(const uint8_t* data, size_t length, const char* mimeType, NdefRecordView* record) {
+    size_t messageOffset;
+    uint16_t messageLength;
+
+    if (!ndefFindMessage(data, length, &messageOffset, &messageLength)) return false;
+    if (messageOffset >= length) return false;
+
+    const uint8_t* message = &data[messageOffset];
+    size_t available = length - messageOffset;
+    if (available > messageLength) available = messageLength;
+
+    size_t offset = 0;
+    while (ndefNextRecord(message, available, &offset, record)) {
+        // Reject records that claim more payload than the TLV announced
+        if ((size_t)(record->payload - message) + record->payloadLength > messageLength) return false;
+
+        if (mimeType == NULL ? isJsonRecord(record) : isMimeRecord(record, mimeType)) return true;
+        if (record->header & NDEF_FLAG_ME) break;
+    }
+
+    return false;
+}
+
+bool ndefFindJsonRecord(const uint8_t* data, size_t length, NdefRecordView* record) {
+    return findRecord(data, length, NULL, record);
+}
+
+bool ndefFindMimeRecord(const uint8_t* data, size_t length, const char* mimeType, NdefRecordView* record) {
+    return findRecord(data, length, mimeType, record);
+}
+
+bool ndefSourceRequire(NdefSource* source, size_t length) {
+    if (length <= source->available) return true;
+    if (length > source->capacity || source->fetch == NULL) return false;
+    return source->fetch(source, length) && source->available >= length;
+}
+
+// Payload bytes of the record that are loaded by now
+static void refreshRecord(const NdefSource* source, NdefRecordView* record) {
+    size_t payloadOffset = record->payload - source->data;
+    size_t loaded = source->available > payloadOffset ? source->available - payloadOffset : 0;
+    record->availableLength = loaded < record->payloadLength ? loaded : record->payloadLength;
+}
+
+bool ndefSourceFindRecord(NdefSource* source, const char* mimeType, NdefRecordView* record) {
+    size_t offset = 0;
+    size_t messageOffset;
+    uint16_t messageLength;
+
+    // Same TLV walk as ndefFindMessage, one header at a time
+    while (true) {
+        if (!ndefSourceRequire(source, offset + 1)) return false;
+        uint8_t tlvType = source->data[offset];
+
+        if (tlvType == NDEF_TLV_NULL) {
+            offset++;
+            continue;
+        }
+        if (tlvType == NDEF_TLV_TERMINATOR || !ndefSourceRequire(source, offset + 2)) {
+            return false;
+        }
+
+        uint16_t tlvLength = source->data[offset + 1];
+        size_t valueOffset = offset + 2;
+        if (tlvLength == 0xFF) {
+            if (!ndefSourceRequire(source, offset + 4)) return false;
+            tlvLength = (source->data[offset + 2] << 8) | source->data[offset + 3];
+            valueOffset = offset + 4;
+        }
+
+        if (tlvType == NDEF_TLV_MESSAGE) {
+            messageOffset = valueOffset;
+            messageLength = tlvLength;
+            break;
+        }
+        offset = valueOffset + tlvLength;
+    }
+
+    size_t messageEnd = messageOffset + messageLength;
+    size_t pos = messageOffset;
+
+    while (pos < messageEnd) {
+        // Header, type and ID plus the first payload byte for the JSON check
+        if (!ndefSourceRequire(source, pos + 2)) return false;
+        uint8_t header = source->data[pos];
+        size_t lengthBytes = (header & NDEF_FLAG_SR) ? 1 : 4;
+        size_t idLengthBytes = (header & NDEF_FLAG_IL) ? 1 : 0;
+        if (!ndefSourceRequire(source, pos + 2 + lengthBytes + idLengthBytes)) return false;
+        size_t idLength = idLengthBytes ? source->data[pos + 2 + lengthBytes] : 0;
+        size_t payloadOffset = pos + 2 + lengthBytes + idLengthBytes + source->data[pos + 1] + idLength;
+        if (payloadOffset < messageEnd && !ndefSourceRequire(source, payloadOffset + 1)) return false;
+
+        size_t loadedEnd = source->available < messageEnd ? source->available : messageEnd;
+        size_t recordOffset = pos - messageOffset;
+        if (!ndefNextRecord(&source->data[messageOffset], loadedEnd - messageOffset, &recordOffset, record)) return false;
+
+        // Reject records that claim more payload than the TLV announced
+        if (recordOffset > messageLength) return false;
+
+        if (mimeType == NULL ? isJsonRecord(record) : isMimeRecord(record, mimeType)) return true;
+        if (record->header & NDEF_FLAG_ME) break;
+        pos = messageOffset + recordOffset;
+    }
+
+    return false;
+}
+
+bool ndefSourceLoadPayload(NdefSource* source, NdefRecordView* record) {
+    size_t payloadOffset = record->payload - source->data;
+    if (!ndefSourceRequire(source, payloadOffset + record->payloadLength)) return false;
+    refreshRecord(source, record);
+    return true;
+}
+
+bool ndefSourceFindJsonValue(NdefSource* source, NdefRecordView* record, const char* key, const char** value, size_t* valueLength) {
+    while (true) {
+        refreshRecord(source, record);
+        const char* json = (const char*)record->payload;
+        if (jsonFindValue(json, record->availableLength, key, value, valueLength)) return true;
+
+        // Key is not in the complete object
+        if (record->availableLength == record->payloadLength || jsonObjectLength(json, record->availableLength) > 0) {
+            return false;
+        }
+        if (!ndefSourceRequire(source, source->available + 1)) return false;
+    }
+}
+
+size_t jsonObjectLength(const char* json, size_t length) {
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = json[i];
+
+        if (inString) {
+            if (escaped) escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"') inString = false;
+            continue;
+        }
+
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) return i + 1;
+            if (depth < 0) return 0;
+        } else if (c == '\0') {
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+// Skips a JSON string starting at the opening quote, returns the position after the closing quote
+static size_t skipJsonString(const char* json, size_t length, size_t pos) {
+    for (pos++; pos < length; pos++) {
+        if (json[pos] == '\\') pos++;
+        else if (json[pos] == '"') return pos + 1;
+    }
+    return length + 1;
+}
+
+static size_t skipJsonWhitespace(const char* json, size_t length, size_t pos) {
+    while (pos < length && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\r' || json[pos] == '\n')) pos++;
+    return pos;
+}
+
+bool jsonFindValue(const char* json, size_t length, const char* key, const char** value, size_t* valueLength) {
+    size_t keyLength = strlen(key);
+    size_t pos = skipJsonWhitespace(json, length, 0);
+
+    if (pos >= length || json[pos] != '{') return false;
+    pos++;
+
+    while (true) {
+        pos = skipJsonWhitespace(json, length, pos);
+        if (pos >= length || json[pos] != '"') return false;
+
+        size_t keyStart = pos + 1;
+        pos = skipJsonString(json, length, pos);
+        if (pos > length) return false;
+        bool keyMatches = (pos - 1 - keyStart == keyLength) && memcmp(&json[keyStart], key, keyLength) == 0;
+
+        pos = skipJsonWhitespace(json, length, pos);
+        if (pos >= length || json[pos] != ':') return false;
+        pos = skipJsonWhitespace(json, length, pos + 1);
+        if (pos >= length) return false;
+
+        // Find the end of the value
+        size_t valueStart = pos;
+        size_t valueEnd;
+        if (json[pos] == '"') {
+            pos = skipJsonString(json, length, pos);
+            if (pos > length) return false;
+            valueStart++;
+            valueEnd = pos - 1;
+        } else if (json[pos] == '{' || json[pos] == '[') {
+            size_t nestedLength = jsonObjectLength(&json[pos], length - pos);
+            if (nestedLength == 0) return false;
+            pos += nestedLength;
+            valueEnd = pos;
+        } else {
+            while (pos < length && json[pos] != ',' && json[pos] != '}' && json[pos] != ' ' && json[pos] != '\r' && json[pos] != '\n') pos++;
+            // A number at the end of the buffer may continue on the next page
+            if (pos >= length) return false;
+            valueEnd = pos;
+        }
+
+        if (keyMatches) {
+            *value = &json[valueStart];
+            *valueLength = valueEnd - valueStart;
+            return true;
+        }
+
+        pos = skipJsonWhitespace(json, length, pos);
+        if (pos >= length || json[pos] != ',') return false;
+        pos++;
+    }
+}
+
+uint32_t jsonValueToUint(const char* value, size_t length) {
+    if (length == 0 || length > 9) return 0;
+
+    uint32_t number = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (value[i] < '0' || value[i] > '9') return 0;
+        number = number * 10 + (value[i] - '0');
+    }
+    return number;
+}
+
+static bool parseJsonHex4(const char* hex, uint32_t* code) {
+    *code = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        char c = hex[i];
+        uint8_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        *code = (*code << 4) | digit;
+    }
+    return true;
+}
+
+static uint8_t encodeUtf8(uint32_t code, char* utf8) {
+    if (code < 0x80) {
+        utf8[0] = code;
+        return 1;
+    }
+    if (code < 0x800) {
+        utf8[0] = 0xC0 | (code >> 6);
+        utf8[1] = 0x80 | (code & 0x3F);
+        return 2;
+    }
+    if (code < 0x10000) {
+        utf8[0] = 0xE0 | (code >> 12);
+        utf8[1] = 0x80 | ((code >> 6) & 0x3F);
+        utf8[2] = 0x80 | (code & 0x3F);
+        return 3;
+    }
+    utf8[0] = 0xF0 | (code >> 18);
+    utf8[1] = 0x80 | ((code >> 12) & 0x3F);
+    utf8[2] = 0x80 | ((code >> 6) & 0x3F);
+    utf8[3] = 0x80 | (code & 0x3F);
+    return 4;
+}
+
+// Decodes the character at pos into utf8. Returns the bytes it takes in value, 0 if it is cut off.
+static size_t decodeJsonChar(const char* value, size_t length, size_t pos, char* utf8, uint8_t* utf8Length) {
+    uint8_t lead = value[pos];
+    if (lead != '\\') {
+        // UTF-8 sequences stay together, a cut value must not end in half a character
+        size_t step = lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : (lead >= 0xC0 ? 2 : 1));
+        if (pos + step > length) return 0;
+        memcpy(utf8, &value[pos], step);
+        *utf8Length = step;
+        return step;
+    }
+
+    if (pos + 1 >= length) return 0;
+    *utf8Length = 1;
+    switch (value[pos + 1]) {
+        case 'b': utf8[0] = '\b'; return 2;
+        case 'f': utf8[0] = '\f'; return 2;
+        case 'n': utf8[0] = '\n'; return 2;
+        case 'r': utf8[0] = '\r'; return 2;
+        case 't': utf8[0] = '\t'; return 2;
+        case 'u': break;
+        default: utf8[0] = value[pos + 1]; return 2;   // \" \\ \/
+    }
+
+    uint32_t code;
+    if (pos + 6 > length || !parseJsonHex4(&value[pos + 2], &code)) return 0;
+    size_t step = 6;
+
+    // Characters outside the BMP come as a surrogate pair
+    uint32_t low;
+    if (code >= 0xD800 && code < 0xDC00 && pos + 12 <= length && value[pos + 6] == '\\' && value[pos + 7] == 'u' &&
+        parseJsonHex4(&value[pos + 8], &low) && low >= 0xDC00 && low < 0xE000) {
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        step = 12;
+    }
+    *utf8Length = encodeUtf8(code, utf8);
+    return step;
+}
+
+size_t jsonCopyValue(char* target, size_t size, const char* value, size_t length) {
+    size_t used = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        char utf8[4];
+        uint8_t utf8Length;
+        size_t step = decodeJsonChar(value, length, pos, utf8, &utf8Length);
+        if (step == 0 || used + utf8Length >= size) break;
+        memcpy(&target[used], utf8, utf8Length);
+        used += utf8Length;
+        pos += step;
+    }
+    target[used] = '\0';
+    return used;
+}
+
+size_t jsonEscapeValue(char* target, size_t size, const char* text) {
+    size_t length = 0;
+    size_t written = 0;
+    bool full = false;
+    for (; *text; text++) {
+        char escaped[7];
+        uint8_t c = *text;
+        size_t step = 2;
+        escaped[0] = '\\';
+        switch (c) {
+            case '"': escaped[1] = '"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                if (c < 0x20) {
+                    step = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                } else {
+                    escaped[0] = c;
+                    step = 1;
+                }
+        }
+
+        if (!full && written + step < size) {
+            memcpy(&target[written], escaped, step);
+            written += step;
+        } else {
+            full = true;
+        }
+        length += step;
+    }
+    if (size > 0) target[written] = '\0';
+    return length;
+}
+
+uint16_t ndefEncodeChecksumTlv(uint32_t checksum, uint8_t* buffer) {
+    buffer[0] = NDEF_TLV_PROPRIETARY;
+    buffer[1] = NDEF_CHECKSUM_TLV_SIZE - 2;
+    buffer[2] = 'S';
+    buffer[3] = 'C';
+    buffer[4] = (uint8_t)(checksum >> 24);
+    buffer[5] = (uint8_t)(checksum >> 16);
+    buffer[6] = (uint8_t)(checksum >> 8);
+    buffer[7] = (uint8_t)checksum;
+    return NDEF_CHECKSUM_TLV_SIZE;
+}
+
+bool ndefFindChecksum(const uint8_t* data, size_t length, uint32_t* checksum) {
+    if (length < NDEF_CHECKSUM_TLV_SIZE || data[0] != NDEF_TLV_PROPRIETARY ||
+        data[1] != NDEF_CHECKSUM_TLV_SIZE - 2 || data[2] != 'S' || data[3] != 'C') {
+        return false;
+    }
+
+    *checksum = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 8) | data[7];
+    return true;
+}
+
+uint16_t ndefEncodeMimeMessage(const char* mimeType, const uint8_t* payload, uint16_t payloadLength, uint8_t* buffer, uint16_t bufferSize) {
+    uint8_t typeLength = strlen(mimeType);
+    uint16_t totalSize = ndefMessageSize(typeLength, payloadLength);
+
+    if (totalSize > bufferSize) return 0;
+
+    bool shortRecord = payloadLength <= 0xFF;
+    uint16_t recordSize = ndefRecordSize(typeLength, payloadLength);
+    uint16_t offset = 0;
+
+    buffer[offset++] = NDEF_TLV_MESSAGE;
+    if (recordSize <= 0xFE) {
+        buffer[offset++] = (uint8_t)recordSize;
+    } else {
+        buffer[offset++] = 0xFF;
+        buffer[offset++] = (uint8_t)(recordSize >> 8);
+        buffer[offset++] = (uint8_t)(recordSize & 0xFF);
+    }
+
+    buffer[offset++] = NDEF_FLAG_MB | NDEF_FLAG_ME | (shortRecord ? NDEF_FLAG_SR : 0) | NDEF_TNF_MIME_MEDIA;
+    buffer[offset++] = typeLength;
+    if (shortRecord) {
+        buffer[offset++] = (uint8_t)payloadLength;
+    } else {
+        buffer[offset++] = 0;
+        buffer[offset++] = 0;
+        buffer[offset++] = (uint8_t)(payloadLength >> 8);
+        buffer[offset++] = (uint8_t)(payloadLength & 0xFF);
+    }
+
+    memcpy(&buffer[offset], mimeType, typeLength);
+    offset += typeLength;
+    memcpy(&buffer[offset], payload, payloadLength);
+    offset += payloadLength;
+
+    buffer[offset++] = NDEF_TLV_TERMINATOR;
+    return offset;
+}
@@ -0,0 +1,259 @@
+#ifndef NDEF_H
+#define NDEF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// NDEF/TLV helpers working on caller-supplied buffers. No heap allocations and no
+// Arduino dependencies, so the module can also be built for a native environment.
+
+#define NDEF_TLV_NULL               0x00
+#define NDEF_TLV_LOCK_CONTROL       0x01
+#define NDEF_TLV_MEMORY_CONTROL     0x02
+#define NDEF_TLV_MESSAGE            0x03
+#define NDEF_TLV_PROPRIETARY        0xFD
+#define NDEF_TLV_TERMINATOR         0xFE
+
+// Proprietary TLV written in front of the message: "SC" and the CRC32 of the record payload.
+// It fills pages 4-5 exactly, readers that do not know it skip it like any proprietary TLV.
+#define NDEF_CHECKSUM_TLV_SIZE      8
+
+#define NDEF_FLAG_MB                0x80
+#define NDEF_FLAG_ME                0x40
+#define NDEF_FLAG_CF                0x20
+#define NDEF_FLAG_SR                0x10
+#define NDEF_FLAG_IL                0x08
+#define NDEF_TNF_MASK               0x07
+#define NDEF_TNF_MIME_MEDIA         0x02
+
+#define NDEF_MIME_JSON              "application/json"
+#define NDEF_MIME_CBOR              "application/cbor"
+
+// View into a record of a (possibly partially read) NDEF message
+typedef struct {
+    uint8_t header;
+    const uint8_t* type;
+    uint8_t typeLength;
+    const uint8_t* payload;
+    uint32_t payloadLength;    // length announced by the record header
+    uint32_t availableLength;  // payload bytes actually present in the buffer
+} NdefRecordView;
+
+// Locates the NDEF Message TLV. Sets the offset of the first record and the announced message length.
+bool ndefFindMessage(const uint8_t* data, size_t length, size_t* messageOffset, uint16_t* messageLength);
+
+// Parses the record at *offset of the message and advances *offset to the next record.
+bool ndefNextRecord(const uint8_t* message, size_t messageLength, size_t* offset, NdefRecordView* record);
+
+// Finds the JSON record (MIME application/json or payload starting with '{') of the NDEF area.
+bool ndefFindJsonRecord(const uint8_t* data, size_t length, NdefRecordView* record);
+
+// Finds the first MIME record with the given type.
+bool ndefFindMimeRecord(const uint8_t* data, size_t length, const char* mimeType, NdefRecordView* record);
+
+// Byte source for reading a tag on demand. The pull functions below call fetch whenever
+// they need bytes beyond available; data has to stay in place while more is loaded.
+typedef struct NdefSource {
+    const uint8_t* data;        // NDEF area, starting with the first TLV
+    size_t available;           // bytes loaded so far
+    size_t capacity;            // size of the NDEF area
+    bool (*fetch)(struct NdefSource* source, size_t length); // loads at least length bytes
+    void* context;
+} NdefSource;
+
+// Makes the first length bytes available, fetching only if they are not loaded yet.
+bool ndefSourceRequire(NdefSource* source, size_t length);
+
+// Pull version of ndefFindJsonRecord (mimeType NULL) and ndefFindMimeRecord: loads the TLV and
+// record headers it walks, but no payload beyond its first byte.
+bool ndefSourceFindRecord(NdefSource* source, const char* mimeType, NdefRecordView* record);
+
+// Loads the complete payload of a record found by ndefSourceFindRecord.
+bool ndefSourceLoadPayload(NdefSource* source, NdefRecordView* record);
+
+// jsonFindValue on a JSON record, loading the payload only until the value or the end of the object.
+bool ndefSourceFindJsonValue(NdefSource* source, NdefRecordView* record, const char* key, const char** value, size_t* valueLength);
+
+// Length of the first complete JSON object in json (string aware), 0 if it is incomplete.
+size_t jsonObjectLength(const char* json, size_t length);
+
+// Finds a top-level value of a JSON object. Strings are returned without quotes and unescaped
+// content is not decoded. Returns false if the key is missing or the value is cut off.
+bool jsonFindValue(const char* json, size_t length, const char* key, const char** value, size_t* valueLength);
+
+// Unsigned decimal value as returned by jsonFindValue, quoted or not. 0 if it is no such number.
+uint32_t jsonValueToUint(const char* value, size_t length);
+
+// Copies a value returned by jsonFindValue into target, NUL terminated and unescaped (\uXXXX as UTF-8).
+// A value that does not fit is cut before a character, never inside one. Returns the copied length.
+size_t jsonCopyValue(char* target, size_t size, const char* value, size_t length);
+
+// Escapes text for a JSON string (without quotes) like snprintf: target gets what fits, NUL terminated
+// and never cut inside an escape sequence. Returns the full escaped length, target may be NULL if size is 0.
+size_t jsonEscapeValue(char* target, size_t size, const char* text);
+
+// Size of a single MIME record (header, type and payload); the payload length takes 1 byte in a short record, 4 otherwise.
+constexpr uint16_t ndefRecordSize(uint8_t typeLength, uint16_t payloadLength) {
+    return 2 + ((payloadLength <= 0xFF) ? 1 : 4) + typeLength + payloadLength;
+}
+
+// Length field of a TLV: 1 byte or 0xFF and 2 bytes.
+constexpr uint8_t ndefTlvLengthSize(uint16_t length) {
+    return (length <= 0xFE) ? 1 : 3;
+}
+
+// Number of bytes the TLV encoded message takes on the tag, including the terminator TLV.
+constexpr uint16_t ndefMessageSize(uint8_t typeLength, uint16_t payloadLength) {
+    return 1 + ndefTlvLengthSize(ndefRecordSize(typeLength, payloadLength)) + ndefRecordSize(typeLength, payloadLength) + 1;
+}
+
+// Encodes the checksum TLV into buffer (NDEF_CHECKSUM_TLV_SIZE bytes), returns its size.
+uint16_t ndefEncodeChecksumTlv(uint32_t checksum, uint8_t* buffer);
+
+// Reads the checksum TLV at the start of the NDEF area, false if the tag has none.
+bool ndefFindChecksum(const uint8_t* data, size_t length, uint32_t* checksum);
+
+// Encodes a single MIME record message as TLV (incl. terminator). Returns the encoded size or 0 if buffer is too small.
+uint16_t ndefEncodeMimeMessage(const char* mimeType, const uint8_t* payload, uint16_t payloadLength, uint8_t* buffer, uint16_t bufferSize);
+
+// ##### Compile-time message templates #####
+// The firmware writes one message shape: the checksum TLV and a single MIME record of a type known
+// at compile time. The header bytes of the three length formats are built by the compiler, a write
+// only copies one of them and fills in the lengths, the checksum and the payload.
+
+constexpr uint8_t ndefStringLength(const char* text, uint8_t length = 0) {
+    return text[length] == '\0' ? length : ndefStringLength(text, length + 1);
+}
+
+template <size_t... Index> struct NdefIndexList {};
+template <size_t Count, size_t... Index> struct NdefIndexRange : NdefIndexRange<Count - 1, Count - 1, Index...> {};
+template <size_t... Index> struct NdefIndexRange<0, Index...> { typedef NdefIndexList<Index...> type; };
+
+typedef enum {
+    NDEF_SHAPE_SHORT,           // Short record in a TLV with 1 byte length
+    NDEF_SHAPE_SHORT_LONG_TLV,  // Short record whose TLV needs the 3 byte length
+    NDEF_SHAPE_LONG,            // Record with 4 byte payload length, 3 byte TLV length
+    NDEF_SHAPE_COUNT
+} ndefShapeType;
+
+constexpr uint8_t ndefShapeTlvLengthSize(uint8_t shape) {
+    return shape == NDEF_SHAPE_SHORT ? 1 : 3;
+}
+
+constexpr uint8_t ndefShapePayloadLengthSize(uint8_t shape) {
+    return shape == NDEF_SHAPE_LONG ? 4 : 1;
+}
+
+// Offset of the record header, behind the checksum TLV and the message TLV tag and length
+constexpr uint8_t ndefShapeRecordOffset(uint8_t shape) {
+    return NDEF_CHECKSUM_TLV_SIZE + 1 + ndefShapeTlvLengthSize(shape);
+}
+
+constexpr uint8_t ndefShapeHeaderSize(uint8_t shape, uint8_t typeLength) {
+    return ndefShapeRecordOffset(shape) + 2 + ndefShapePayloadLengthSize(shape) + typeLength;
+}
+
+// Byte of the header image at index, with zeros in place of the checksum and the lengths and as padding
+constexpr uint8_t ndefShapeByte(uint8_t shape, const char* type, size_t index) {
+    return index >= ndefShapeHeaderSize(shape, ndefStringLength(type)) ? 0
+         : index == 0 ? NDEF_TLV_PROPRIETARY
+         : index == 1 ? NDEF_CHECKSUM_TLV_SIZE - 2
+         : index == 2 ? 'S'
+         : index == 3 ? 'C'
+         : index < NDEF_CHECKSUM_TLV_SIZE ? 0
+         : index == NDEF_CHECKSUM_TLV_SIZE ? NDEF_TLV_MESSAGE
+         : index == NDEF_CHECKSUM_TLV_SIZE + 1 && shape != NDEF_SHAPE_SHORT ? 0xFF
+         : index < ndefShapeRecordOffset(shape) ? 0
+         : index == ndefShapeRecordOffset(shape)
+           ? (NDEF_FLAG_MB | NDEF_FLAG_ME | (shape != NDEF_SHAPE_LONG ? NDEF_FLAG_SR : 0) | NDEF_TNF_MIME_MEDIA)
+         : index == ndefShapeRecordOffset(shape) + 1U ? ndefStringLength(type)
+         : index < ndefShapeRecordOffset(shape) + 2U + ndefShapePayloadLengthSize(shape) ? 0
+         : (uint8_t)type[index - ndefShapeRecordOffset(shape) - 2 - ndefShapePayloadLengthSize(shape)];
+}
+
+// Type is a struct with "static constexpr const char* mime()" returning the MIME type literal
+template <typename Type, typename Index = typename NdefIndexRange<ndefShapeHeaderSize(NDEF_SHAPE_LONG, ndefStringLength(Type::mime()))>::type>
+struct NdefMimeTemplate;
+
+template <typename Type, size_t... Index>
+struct NdefMimeTemplate<Type, NdefIndexList<Index...> > {
+    static constexpr uint8_t TYPE_LENGTH = ndefStringLength(Type::mime());
+    static constexpr uint8_t HEADER_SIZE = sizeof...(Index);  // Longest header, the long shape
+
+    // Largest payload of the short shapes, both record and TLV lengths fit one byte in the first
+    static constexpr uint16_t SHORT_MAX_PAYLOAD = 0xFE - 3 - TYPE_LENGTH;
+    static constexpr uint16_t SHORT_RECORD_MAX_PAYLOAD = 0xFF;
+
+    // Header images of all shapes, each padded to the length of the longest
+    static constexpr uint8_t HEADERS[NDEF_SHAPE_COUNT][HEADER_SIZE] = {
+        { ndefShapeByte(NDEF_SHAPE_SHORT, Type::mime(), Index)... },
+        { ndefShapeByte(NDEF_SHAPE_SHORT_LONG_TLV, Type::mime(), Index)... },
+        { ndefShapeByte(NDEF_SHAPE_LONG, Type::mime(), Index)... },
+    };
+
+    static constexpr uint8_t shape(uint16_t payloadLength) {
+        return payloadLength <= SHORT_MAX_PAYLOAD ? NDEF_SHAPE_SHORT
+             : payloadLength <= SHORT_RECORD_MAX_PAYLOAD ? NDEF_SHAPE_SHORT_LONG_TLV
+             : NDEF_SHAPE_LONG;
+    }
+
+    // Bytes on the tag: checksum TLV, message TLV and terminator TLV
+    static constexpr uint16_t size(uint16_t payloadLength) {
+        return NDEF_CHECKSUM_TLV_SIZE + ndefMessageSize(TYPE_LENGTH, payloadLength);
+    }
+
+    static constexpr bool fits(uint16_t payloadLength, uint16_t userDataSize) {
+        return size(payloadLength) <= userDataSize;
+    }
+
+    // Same bytes as ndefEncodeChecksumTlv followed by ndefEncodeMimeMessage. Returns the encoded
+    // size or 0 if buffer is too small.
+    static uint16_t encode(uint32_t checksum, const uint8_t* payload, uint16_t payloadLength, uint8_t* buffer, uint16_t bufferSize) {
+        uint16_t totalSize = size(payloadLength);
+        if (totalSize > bufferSize) return 0;
+
+        uint8_t recordShape = shape(payloadLength);
+        uint8_t headerSize = ndefShapeHeaderSize(recordShape, TYPE_LENGTH);
+        memcpy(buffer, HEADERS[recordShape], headerSize);
+
+        buffer[4] = (uint8_t)(checksum >> 24);
+        buffer[5] = (uint8_t)(checksum >> 16);
+        buffer[6] = (uint8_t)(checksum >> 8);
+        buffer[7] = (uint8_t)checksum;
+
+        uint16_t recordSize = ndefRecordSize(TYPE_LENGTH, payloadLength);
+        uint8_t recordOffset = ndefShapeRecordOffset(recordShape);
+        if (recordShape == NDEF_SHAPE_SHORT) {
+            buffer[NDEF_CHECKSUM_TLV_SIZE + 1] = (uint8_t)recordSize;
+        } else {
+            buffer[NDEF_CHECKSUM_TLV_SIZE + 2] = (uint8_t)(recordSize >> 8);
+            buffer[NDEF_CHECKSUM_TLV_SIZE + 3] = (uint8_t)recordSize;
+        }
+        if (recordShape == NDEF_SHAPE_LONG) {
+            buffer[recordOffset + 4] = (uint8_t)(payloadLength >> 8);
+            buffer[recordOffset + 5] = (uint8_t)payloadLength;
+        } else {
+            buffer[recordOffset + 2] = (uint8_t)payloadLength;
+        }
+
+        memcpy(&buffer[headerSize], payload, payloadLength);
+        buffer[totalSize - 1] = NDEF_TLV_TERMINATOR;
+        return totalSize;
+    }
+};
+
+template <typename Type, size_t... Index>
+constexpr uint8_t NdefMimeTemplate<Type, NdefIndexList<Index...> >::HEADERS[NDEF_SHAPE_COUNT][HEADER_SIZE];
+
+struct NdefJsonType { static constexpr const char* mime() { return NDEF_MIME_JSON; } };
+struct NdefCborType { static constexpr const char* mime() { return NDEF_MIME_CBOR; } };
+
+typedef NdefMimeTemplate<NdefJsonType> NdefJsonTemplate;
+typedef NdefMimeTemplate<NdefCborType> NdefCborTemplate;
+
+static_assert(NdefJsonTemplate::HEADERS[NDEF_SHAPE_SHORT][NDEF_CHECKSUM_TLV_SIZE + 3] == 16, "application/json has 16 characters");
+static_assert(NdefJsonTemplate::size(NdefJsonTemplate::SHORT_MAX_PAYLOAD) == NDEF_CHECKSUM_TLV_SIZE + 2 + 0xFE + 1,
+              "the largest short shape fills a TLV with 1 byte length");
+
+#endif
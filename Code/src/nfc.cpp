@@ -1,7 +1,9 @@
 #include "nfc.h"
 #include <Arduino.h>
 #include <Adafruit_PN532.h>
+#include <Wire.h>
 #include <ArduinoJson.h>
+#include <new>
 #include "config.h"
 #include "website.h"
 #include "api.h"
@@ -9,28 +11,172 @@
 #include "scale.h"
 #include "bambu.h"
 #include "main.h"
+#include "ndef.h"
+#include "tagCache.h"
+#include "spoolCbor.h"
+#include "tagStats.h"
+#include "nfcLatency.h"
+
+// Driver for the link selected in config.cpp, the library brings the I2C, SPI and HSU code
+Adafruit_PN532* createPn532(uint8_t irqPin) {
+  switch (PN532_TRANSPORT) {
+    case PN532_TRANSPORT_SPI:
+      return new Adafruit_PN532(PN532_SS);
+    case PN532_TRANSPORT_HSU:
+      return new Adafruit_PN532(PN532_RESET, &Serial1);
+    default:
+      return new Adafruit_PN532(irqPin, PN532_RESET);
+  }
+}
 
-//Adafruit_PN532 nfc(PN532_SCK, PN532_MISO, PN532_MOSI, PN532_SS);
-Adafruit_PN532 nfc(PN532_IRQ, PN532_RESET);
+Adafruit_PN532* nfc = createPn532(PN532_IRQ); // Driver of the selected reader, the scale reader until selectReader()
 
 TaskHandle_t RfidReaderTask;
 
 JsonDocument rfidData;
-String activeSpoolId = "";
-String lastSpoolId = "";
-String nfcJsonData = "";
-bool tagProcessed = false;
-volatile bool pauseBambuMqttTask = false;
-volatile bool nfcReadingTaskSuspendRequest = false;
-volatile bool nfcReadingTaskSuspendState = false;
-volatile bool nfcWriteInProgress = false; // Prevent any tag operations during write
-
-struct NfcWriteParameterType {
-  bool tagType;
-  char* payload;
+uint32_t activeSpoolId = 0;
+uint32_t lastSpoolId = 0;
+
+// NTAG2xx commands sent as raw InDataExchange frames
+#define NTAG_CMD_READ               0x30
+#define NTAG_CMD_FAST_READ          0x3A
+#define NTAG_CMD_GET_VERSION        0x60
+// The PN532 packet buffer is 64 bytes, 12 pages keep the response frame within it
+#define NTAG_FAST_READ_MAX_PAGES    12
+
+// Product type byte of the GET_VERSION response
+#define NTAG_PRODUCT_ULTRALIGHT     0x03
+#define NTAG_PRODUCT_NTAG           0x04
+#define NTAG_CAPABILITY_CACHE_SIZE  16
+
+uint16_t nfcRoundTrips = 0; // PN532 round trips of the current bulk read
+uint16_t nfcPagesWritten = 0; // Pages changed by the last write
+uint16_t nfcPagesSkipped = 0; // Pages already up to date during the last write
+volatile bool nfcIrqArmed = false; // ISR may notify the reader task
+bool nfcIrqListening = false; // InListPassiveTarget is pending on the PN532
+bool nfcRfFieldOff = false; // Switched off by the duty cycle between two polls
+unsigned long nfcLastActivity = 0; // Last tag, command or weight step, ends the duty cycle for a while
+volatile bool nfcWeightStepPending = false; // Set by the scale task
+volatile bool nfcDutyCycleSleeping = false; // Only then the scale task may wake the NFC task
+
+#define NFC_COMMAND_QUEUE_LENGTH    4
+#define NFC_WRITE_SLOT_COUNT        3       // Writes that can be queued back-to-back
+#define NFC_MAX_SUBSCRIBERS         4
+
+QueueHandle_t nfcCommandQueue = NULL;
+NfcEventCallback nfcSubscribers[NFC_MAX_SUBSCRIBERS];
+uint8_t nfcSubscriberCount = 0;
+bool nfcSuspended = false;
+bool nfcRescanRequested = false; // NFC_CMD_SCAN: treat the tag on the reader as new
+uint8_t nfcPresentUid[7]; // Tag processed last and still on the reader
+uint8_t nfcPresentUidLength = 0;
+
+// Tag capabilities, identified by product type and storage size byte of GET_VERSION
+struct NtagCapability {
+  uint8_t productType;
+  uint8_t storageSize;
+  const char* name;
+  uint8_t lastUserPage;
+  bool fastRead;
+};
+
+static constexpr NtagCapability NTAG_CAPABILITIES[] = {
+  { NTAG_PRODUCT_NTAG,       0x0B, "NTAG210",  15, true },
+  { NTAG_PRODUCT_NTAG,       0x0E, "NTAG212",  35, true },
+  { NTAG_PRODUCT_NTAG,       0x0F, "NTAG213",  39, true },
+  { NTAG_PRODUCT_NTAG,       0x11, "NTAG215", 129, true },
+  { NTAG_PRODUCT_NTAG,       0x13, "NTAG216", 225, true },
+  { NTAG_PRODUCT_ULTRALIGHT, 0x0B, "MF0UL11",  15, true },
+  { NTAG_PRODUCT_ULTRALIGHT, 0x0E, "MF0UL21",  35, true },
+};
+
+static constexpr size_t NTAG_CAPABILITY_COUNT = sizeof(NTAG_CAPABILITIES) / sizeof(NTAG_CAPABILITIES[0]);
+
+static constexpr const NtagCapability* findNtagCapability(uint8_t productType, uint8_t storageSize, size_t index = 0) {
+  return index >= NTAG_CAPABILITY_COUNT ? nullptr
+       : (NTAG_CAPABILITIES[index].productType == productType && NTAG_CAPABILITIES[index].storageSize == storageSize)
+         ? &NTAG_CAPABILITIES[index]
+         : findNtagCapability(productType, storageSize, index + 1);
+}
+
+static_assert(findNtagCapability(NTAG_PRODUCT_NTAG, 0x0F)->lastUserPage == 39, "NTAG213 user memory ends at page 39");
+static_assert(findNtagCapability(NTAG_PRODUCT_NTAG, 0x13)->lastUserPage == 225, "NTAG216 user memory ends at page 225");
+
+static constexpr uint16_t ntagUserDataSize(const NtagCapability& tag) {
+  return (tag.lastUserPage - 3) * 4;
+}
+
+struct NtagCapabilityCacheEntry {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  NtagCapability capability;
+};
+
+static NtagCapabilityCacheEntry capabilityCache[NTAG_CAPABILITY_CACHE_SIZE];
+static uint8_t capabilityCacheCount = 0;
+static uint8_t capabilityCacheNext = 0;
+NtagCapability currentTag; // Capabilities of the tag currently processed by the scan task
+
+// Largest user memory of the supported tags (NTAG216), no record can be longer
+static constexpr uint16_t NFC_MAX_RECORD_LENGTH = ntagUserDataSize(*findNtagCapability(NTAG_PRODUCT_NTAG, 0x13));
+static constexpr uint16_t NTAG213_USER_DATA_SIZE = ntagUserDataSize(*findNtagCapability(NTAG_PRODUCT_NTAG, 0x0F));
+
+// The tags this firmware hands out must fit the smallest common tag: a location with the longest
+// name Spoolman gets from us, and a spool with the fields the tag cache keeps
+static constexpr uint16_t LOCATION_TAG_MAX_PAYLOAD = sizeof("{\"location\":\"\"}") - 1 + SPOOLMAN_LOCATION_MAX_LENGTH - 1;
+static constexpr uint16_t SPOOL_TAG_MAX_PAYLOAD =
+  sizeof("{\"sm_id\":\"4294967295\",\"brand\":\"\",\"type\":\"\",\"color_hex\":\"\"}") - 1 +
+  sizeof(TagCacheEntry::spool.brand) - 1 + sizeof(TagCacheEntry::spool.type) - 1 + sizeof(TagCacheEntry::spool.colorHex) - 1;
+
+static_assert(NdefJsonTemplate::fits(LOCATION_TAG_MAX_PAYLOAD, NTAG213_USER_DATA_SIZE), "location tags must fit an NTAG213");
+static_assert(NdefJsonTemplate::fits(SPOOL_TAG_MAX_PAYLOAD, NTAG213_USER_DATA_SIZE), "spool tags must fit an NTAG213");
+static_assert(NdefJsonTemplate::shape(SPOOL_TAG_MAX_PAYLOAD) == NDEF_SHAPE_SHORT, "spool tags use the short record");
+
+// Buffers of one queued write, taken from a fixed pool so writes do not touch the heap
+struct NfcWriteSlot {
+  char payload[NFC_MAX_RECORD_LENGTH + 1];    // JSON, used for Spoolman and the cache
+  uint8_t record[NFC_MAX_RECORD_LENGTH];      // CBOR record, JSON records are written from payload
+};
+
+static NfcWriteSlot nfcWriteSlots[NFC_WRITE_SLOT_COUNT];
+QueueHandle_t nfcFreeSlotQueue = NULL; // Slots that are not part of a queued write
+
+// Encoding buffer of the write in progress and the page image of the tag, used for the diff of
+// a write and for reads. Only used by the NFC task, reads and writes never overlap.
+static uint8_t nfcTlvBuffer[NFC_MAX_RECORD_LENGTH];
+static uint8_t nfcCurrentPages[NFC_MAX_RECORD_LENGTH];
+
+// JSON of the tag last read. Fixed size so a scan does not touch the heap; CBOR records decoded
+// to JSON that do not fit are refused like a tag that cannot be read.
+char nfcJsonData[NFC_JSON_DATA_SIZE] = "";
+static_assert(NFC_JSON_DATA_SIZE == NFC_MAX_RECORD_LENGTH + 1, "NFC_JSON_DATA_SIZE must hold the longest record");
+
+// Bulk programming run, owned by the NFC task once NFC_CMD_BATCH_START is handled
+struct NfcBatch {
+  bool isSpoolTag;
+  nfcPayloadFormatType format;
+  uint16_t count;
+  uint16_t written;                             // Payloads already on a tag
+  const char* nextPayload;                      // Optimized JSON for the next tag
+  char* payloads;                               // All payloads, NUL separated
+  NfcWriteSlot* slot;                           // Encoding buffers, held for the whole batch
+  uint8_t writtenUids[NFC_BATCH_MAX_TAGS][7];   // A tag put back on the reader is not written twice
 };
 
-volatile nfcReaderStateType nfcReaderState = NFC_IDLE;
+static NfcBatch* nfcBatch = NULL; // Running batch, only used by the NFC task
+
+struct NfcCommand {
+  nfcCommandType type;
+  bool isSpoolTag;
+  NfcWriteSlot* slot;
+  const uint8_t* record;  // Record payload written to the tag (JSON or CBOR)
+  uint16_t recordLength;
+  nfcPayloadFormatType format;  // Selects the MIME type of the record
+  NfcBatch* batch;        // NFC_CMD_BATCH_START only
+};
+
+// Only changed by the NFC task, other modules follow it through events
+nfcReaderStateType nfcReaderState = NFC_IDLE;
 // 0 = nicht gelesen
 // 1 = erfolgreich gelesen
 // 2 = fehler beim Lesen
@@ -40,6 +186,152 @@ volatile nfcReaderStateType nfcReaderState = NFC_IDLE;
 // 6 = reading
 // ***** PN532
 
+// ##### Reader #####
+// Scan state every reader has on its own. The scan code works on the globals of the selected
+// reader, selectReader() stores them and loads the ones of the next reader.
+struct NfcReader {
+  NfcReaderConfig config;
+  Adafruit_PN532* pn532;
+  nfcReaderStateType state;
+  uint8_t presentUid[7];
+  uint8_t presentUidLength;
+  bool rescanRequested;
+  bool irqListening;
+};
+
+static NfcReader nfcReaders[NFC_MAX_READERS];
+static uint8_t nfcReaderCount = 1;
+static uint8_t nfcSelectedReader = NFC_SCALE_READER;
+static uint8_t nfcRoundStart = 0; // Reader with the first turn of the next round
+
+// TCA9548A: the control byte connects the channels of its set bits
+bool selectMuxChannel(int8_t channel) {
+  if (channel == NFC_MUX_NONE) return true;
+  Wire.beginTransmission(NFC_MUX_ADDRESS);
+  Wire.write((uint8_t)(1 << channel));
+  return Wire.endTransmission() == 0;
+}
+
+void selectReader(uint8_t index) {
+  if (index == nfcSelectedReader) return;
+
+  NfcReader& previous = nfcReaders[nfcSelectedReader];
+  previous.state = nfcReaderState;
+  memcpy(previous.presentUid, nfcPresentUid, sizeof(nfcPresentUid));
+  previous.presentUidLength = nfcPresentUidLength;
+  previous.rescanRequested = nfcRescanRequested;
+  previous.irqListening = nfcIrqListening;
+
+  NfcReader& next = nfcReaders[index];
+  nfcReaderState = next.state;
+  memcpy(nfcPresentUid, next.presentUid, sizeof(nfcPresentUid));
+  nfcPresentUidLength = next.presentUidLength;
+  nfcRescanRequested = next.rescanRequested;
+  nfcIrqListening = next.irqListening;
+  nfc = next.pn532;
+  nfcSelectedReader = index;
+
+  if (!selectMuxChannel(next.config.muxChannel)) {
+    Serial.printf("Multiplexer-Kanal %d antwortet nicht\n", next.config.muxChannel);
+  }
+}
+
+// Only the scale reader has an active spool, the weight belongs to it
+void setActiveSpool(uint32_t spoolId) {
+  if (nfcSelectedReader == NFC_SCALE_READER) activeSpoolId = spoolId;
+}
+
+// ##### Events und Kommandos #####
+bool nfcSubscribe(NfcEventCallback callback) {
+  if (nfcSubscriberCount >= NFC_MAX_SUBSCRIBERS) return false;
+  nfcSubscribers[nfcSubscriberCount++] = callback;
+  return true;
+}
+
+void emitNfcEvent(nfcEventType type, bool success, const char* uid = "", const char* payload = "", bool isSpoolTag = false) {
+  NfcEvent event = { type, nfcReaderState, success, isSpoolTag, uid, payload,
+                     nfcBatch ? nfcBatch->written : (uint16_t)0, nfcBatch ? nfcBatch->count : (uint16_t)0, nfcSelectedReader };
+  for (uint8_t i = 0; i < nfcSubscriberCount; i++) {
+    nfcSubscribers[i](event);
+  }
+}
+
+bool queueNfcCommand(const NfcCommand& command, uint32_t timeoutMs = 0) {
+  if (nfcCommandQueue == NULL || xQueueSend(nfcCommandQueue, &command, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) return false;
+  // Wakes the task from a pending IRQ detection
+  if (RfidReaderTask != NULL) xTaskNotifyGive(RfidReaderTask);
+  return true;
+}
+
+void releaseWriteSlot(NfcWriteSlot* slot) {
+  xQueueSend(nfcFreeSlotQueue, &slot, 0);
+}
+
+bool nfcSendCommand(nfcCommandType type, uint32_t timeoutMs) {
+  NfcCommand command = {};
+  command.type = type;
+  return queueNfcCommand(command, timeoutMs);
+}
+
+// Waits for the next command instead of a plain delay, returns early when one is queued
+void waitForNfcCommand(uint32_t timeoutMs) {
+  NfcCommand command;
+  xQueuePeek(nfcCommandQueue, &command, pdMS_TO_TICKS(timeoutMs));
+}
+
+// Same text as String(byte, HEX) per byte: lower case, no leading zero, separated by ':'
+void formatUid(const uint8_t* uid, uint8_t uidLength, char* uidString) {
+  char* end = uidString;
+  *end = '\0';
+  for (uint8_t i = 0; i < uidLength && i < 7; i++) {
+    end += sprintf(end, i < uidLength - 1 ? "%x:" : "%x", uid[i]);
+  }
+}
+
+void rememberPresentTag(const uint8_t* uid, uint8_t uidLength) {
+    nfcPresentUidLength = min((int)uidLength, (int)sizeof(nfcPresentUid));
+    memcpy(nfcPresentUid, uid, nfcPresentUidLength);
+}
+
+// Re-selects the tag on the reader with short timeouts instead of a full detection.
+// A single missed answer is not taken as removal.
+bool checkTagPresence(uint8_t* uid, uint8_t* uidLength) {
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, NFC_PRESENCE_TIMEOUT)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// All readers share the reset line, a begin() restarts the other ones as well: their pending
+// detections are gone and SAMConfig has to be sent again
+void restartOtherReaders() {
+  uint8_t selected = nfcSelectedReader;
+  for (uint8_t i = 0; i < nfcReaderCount; i++) {
+    if (i == selected) continue;
+    selectReader(i);
+    nfcIrqListening = false;
+    nfc->SAMConfig();
+  }
+  selectReader(selected);
+}
+
+// Starts the link to the PN532. The driver opens the bus itself, the I2C clock is set afterwards
+// and Serial1 keeps the pins of its first begin() when the driver opens it again.
+bool beginPn532() {
+  if (PN532_TRANSPORT == PN532_TRANSPORT_HSU) {
+    Serial1.begin(115200, SERIAL_8N1, PN532_HSU_RX, PN532_HSU_TX);
+  }
+
+  bool started = nfc->begin();
+  if (PN532_TRANSPORT == PN532_TRANSPORT_I2C) {
+    Wire.setClock(PN532_I2C_CLOCK);
+  }
+  restartOtherReaders();
+  return started;
+}
+
 // ##### Funktionen für RFID #####
 void payloadToJson(uint8_t *data) {
     const char* startJson = strchr((char*)data, '{');
@@ -93,166 +385,213 @@ bool formatNdefTag() {
   
     // Schreibe die Initialisierungsnachricht auf die ersten Seiten
     for (int i = 0; i < sizeof(ndefInit); i += 4) {
-      if (!nfc.ntag2xx_WritePage(pageOffset + (i / 4), &ndefInit[i])) {
+      if (!nfc->ntag2xx_WritePage(pageOffset + (i / 4), &ndefInit[i])) {
           success = false;
           break;
       }
     }
   
     return success;
-}uint16_t readTagSize()
-{
-  uint8_t buffer[4];
-  memset(buffer, 0, 4);
-  nfc.ntag2xx_ReadPage(3, buffer);
-  return buffer[2]*8;
 }
 
-// Robust page reading with error recovery
+// Robust page reading with error recovery, retries follow the statistics of the tag
 bool robustPageRead(uint8_t page, uint8_t* buffer) {
-    const int MAX_READ_ATTEMPTS = 3;
+    TagRetryPolicy policy = tagStatsReadPolicy();
+    uint8_t retries = 0;
+    unsigned long start = micros();
     
-    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+    for (int attempt = 0; attempt < policy.attempts; attempt++) {
         esp_task_wdt_reset();
         yield();
         
-        if (nfc.ntag2xx_ReadPage(page, buffer)) {
+        if (nfc->ntag2xx_ReadPage(page, buffer)) {
+            tagStatsRecordRead(1, retries, true, micros() - start);
             return true;
         }
         
-        Serial.printf("Page %d read failed, attempt %d/%d\n", page, attempt + 1, MAX_READ_ATTEMPTS);
+        Serial.printf("Page %d read failed, attempt %d/%d\n", page, attempt + 1, policy.attempts);
         
         // Try to stabilize connection between attempts
-        if (attempt < MAX_READ_ATTEMPTS - 1) {
-            vTaskDelay(pdMS_TO_TICKS(25));
+        if (attempt < policy.attempts - 1) {
+            retries++;
+            vTaskDelay(pdMS_TO_TICKS(tagStatsRetryDelay(policy, retries)));
             
             // Re-verify tag presence with quick check
             uint8_t uid[7];
             uint8_t uidLength;
-            if (!nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100)) {
+            if (!nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100)) {
                 Serial.println("Tag lost during read operation");
-                return false;
+                break;
             }
         }
     }
     
+    tagStatsRecordRead(1, retries, false, micros() - start);
     return false;
 }
 
-String detectNtagType()
-{
-  // Read capability container from page 3 to determine exact NTAG type
-  uint8_t ccBuffer[4];
-  memset(ccBuffer, 0, 4);
-  
-  if (!nfc.ntag2xx_ReadPage(3, ccBuffer)) {
-    Serial.println("Failed to read capability container");
-    return "UNKNOWN";
-  }
+// Reads one chunk of pages with a single InDataExchange frame.
+// FAST_READ returns exactly the requested range, READ always returns 4 pages (16 bytes).
+bool ntagReadChunk(uint8_t startPage, uint8_t numPages, uint8_t* buffer, bool useFastRead) {
+    uint8_t command[3];
+    uint8_t commandLength;
+    uint8_t response[NTAG_FAST_READ_MAX_PAGES * 4];
+    uint8_t responseLength = sizeof(response);
+    uint8_t expectedLength;
+
+    if (useFastRead) {
+        command[0] = NTAG_CMD_FAST_READ;
+        command[1] = startPage;
+        command[2] = startPage + numPages - 1;
+        commandLength = 3;
+        expectedLength = numPages * 4;
+    } else {
+        command[0] = NTAG_CMD_READ;
+        command[1] = startPage;
+        commandLength = 2;
+        expectedLength = 16;
+        if (numPages > 4) numPages = 4;
+    }
 
-  // Also read configuration pages to get more info
-  uint8_t configBuffer[4];
-  memset(configBuffer, 0, 4);
-  
-  Serial.print("Capability Container: ");
-  for (int i = 0; i < 4; i++) {
-    if (ccBuffer[i] < 0x10) Serial.print("0");
-    Serial.print(ccBuffer[i], HEX);
-    Serial.print(" ");
-  }
-  Serial.println();
+    nfcRoundTrips++;
+    if (!nfc->inDataExchange(command, commandLength, response, &responseLength) || responseLength < expectedLength) {
+        return false;
+    }
 
-  // NTAG type detection based on capability container
-  // CC[2] contains the data area size in bytes / 8
-  uint16_t dataAreaSize = ccBuffer[2] * 8;
-  
-  Serial.print("Data area size from CC: ");
-  Serial.println(dataAreaSize);
+    memcpy(buffer, response, numPages * 4);
+    return true;
+}
 
-  // Try to read different configuration pages to determine exact type
-  String tagType = "UNKNOWN";
-  
-  // Try to read page 41 (NTAG213 ends at page 39, so this should fail)
-  uint8_t testBuffer[4];
-  bool canReadPage41 = nfc.ntag2xx_ReadPage(41, testBuffer);
-  
-  // Try to read page 130 (NTAG215 ends at page 129, so this should fail for NTAG213/215)
-  bool canReadPage130 = nfc.ntag2xx_ReadPage(130, testBuffer);
-
-  if (dataAreaSize <= 180 && !canReadPage41) {
-    tagType = "NTAG213";
-    Serial.println("Detected: NTAG213 (cannot read beyond page 39)");
-  } else if (dataAreaSize <= 540 && canReadPage41 && !canReadPage130) {
-    tagType = "NTAG215";
-    Serial.println("Detected: NTAG215 (can read page 41, cannot read page 130)");
-  } else if (dataAreaSize <= 928 && canReadPage130) {
-    tagType = "NTAG216";
-    Serial.println("Detected: NTAG216 (can read page 130)");
-  } else {
-    // Fallback: use data area size from capability container
-    if (dataAreaSize <= 180) {
-      tagType = "NTAG213";
-      Serial.println("Fallback detection: NTAG213 based on data area size");
-    } else if (dataAreaSize <= 540) {
-      tagType = "NTAG215";
-      Serial.println("Fallback detection: NTAG215 based on data area size");
-    } else {
-      tagType = "NTAG216";
-      Serial.println("Fallback detection: NTAG216 based on data area size");
+// Burst read of consecutive pages with per-chunk retry, attempts and delays follow the statistics of the tag.
+// Tags without FAST_READ (e.g. MIFARE Ultralight) use the 16-byte READ from the start, so they do not
+// pay a NAK and a reselect per burst. A failed FAST_READ falls back to READ as well.
+bool ntag2xx_ReadPages(uint8_t startPage, uint16_t numPages, uint8_t* buffer) {
+    TagRetryPolicy policy = tagStatsReadPolicy();
+    bool useFastRead = currentTag.fastRead;
+    uint16_t pagesRead = 0;
+
+    while (pagesRead < numPages) {
+        uint8_t chunkPages = min((int)(numPages - pagesRead), useFastRead ? NTAG_FAST_READ_MAX_PAGES : 4);
+        uint8_t page = startPage + pagesRead;
+        bool chunkRead = false;
+        uint8_t retries = 0;
+        unsigned long start = micros();
+
+        for (int attempt = 0; attempt < policy.attempts; attempt++) {
+            esp_task_wdt_reset();
+            yield();
+
+            if (ntagReadChunk(page, chunkPages, buffer + pagesRead * 4, useFastRead)) {
+                chunkRead = true;
+                break;
+            }
+
+            Serial.printf("Pages %d-%d read failed, attempt %d/%d\n", page, page + chunkPages - 1, attempt + 1, policy.attempts);
+
+            if (attempt < policy.attempts - 1) {
+                // A NAK puts the tag back into IDLE state, so continue with plain READ after re-selecting it
+                if (useFastRead) {
+                    useFastRead = false;
+                    chunkPages = min((int)chunkPages, 4);
+                }
+                retries++;
+                vTaskDelay(pdMS_TO_TICKS(tagStatsRetryDelay(policy, retries)));
+
+                uint8_t uid[7];
+                uint8_t uidLength;
+                nfcRoundTrips++;
+                if (!nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100)) {
+                    Serial.println("Tag lost during read operation");
+                    break;
+                }
+            }
+        }
+
+        tagStatsRecordRead(chunkPages, retries, chunkRead, micros() - start);
+        if (!chunkRead) return false;
+        pagesRead += chunkPages;
     }
-  }
-  
-  return tagType;
+
+    return true;
 }
 
-uint16_t getAvailableUserDataSize()
-{
-  String tagType = detectNtagType();
-  uint16_t userDataSize = 0;
-  
-  if (tagType == "NTAG213") {
-    // NTAG213: User data from page 4-39 (36 pages * 4 bytes = 144 bytes)
-    userDataSize = 144;
-    Serial.println("NTAG213 confirmed - 144 bytes user data available");
-  } else if (tagType == "NTAG215") {
-    // NTAG215: User data from page 4-129 (126 pages * 4 bytes = 504 bytes)
-    userDataSize = 504;
-    Serial.println("NTAG215 confirmed - 504 bytes user data available");
-  } else if (tagType == "NTAG216") {
-    // NTAG216: User data from page 4-225 (222 pages * 4 bytes = 888 bytes)
-    userDataSize = 888;
-    Serial.println("NTAG216 confirmed - 888 bytes user data available");
-  } else {
-    // Unknown tag type, use conservative estimate
-    uint16_t tagSize = readTagSize();
-    userDataSize = tagSize - 60; // Reserve 60 bytes for headers/config
-    Serial.print("Unknown NTAG type, using conservative estimate: ");
-    Serial.println(userDataSize);
-  }
-  
-  return userDataSize;
+// Demand paging for NdefSource, context is the buffer behind source->data. Loads whole
+// FAST_READ bursts from page 4 on: one more round trip costs more than the extra pages.
+bool fetchNdefPages(NdefSource* source, size_t length) {
+    uint8_t* buffer = (uint8_t*)source->context;
+    uint16_t loadedPages = source->available / 4;
+    uint16_t maxPages = source->capacity / 4;
+    uint16_t neededPages = (length + 3) / 4;
+    uint16_t readPages = ((neededPages - loadedPages + NTAG_FAST_READ_MAX_PAGES - 1) / NTAG_FAST_READ_MAX_PAGES) * NTAG_FAST_READ_MAX_PAGES;
+    readPages = min((int)readPages, (int)(maxPages - loadedPages));
+
+    if (readPages == 0 || !ntag2xx_ReadPages(4 + loadedPages, readPages, buffer + loadedPages * 4)) {
+        Serial.printf("Failed to read pages %d-%d\n", 4 + loadedPages, 3 + loadedPages + readPages);
+        return false;
+    }
+
+    source->available = (loadedPages + readPages) * 4;
+    return true;
 }
 
-uint16_t getMaxUserDataPages()
-{
-  String tagType = detectNtagType();
-  uint16_t maxPages = 0;
-  
-  if (tagType == "NTAG213") {
-    maxPages = 39; // Pages 4-39 are user data
-  } else if (tagType == "NTAG215") {
-    maxPages = 129; // Pages 4-129 are user data
-  } else if (tagType == "NTAG216") {
-    maxPages = 225; // Pages 4-225 are user data
+// Identifies the tag with GET_VERSION, falls back to the capability container for tags
+// that are not in the table (e.g. MIFARE Ultralight without GET_VERSION). Cached per UID.
+bool detectTagCapability(const uint8_t* uid, uint8_t uidLength, NtagCapability* capability) {
+  for (uint8_t i = 0; i < capabilityCacheCount; i++) {
+    if (capabilityCache[i].uidLength == uidLength && memcmp(capabilityCache[i].uid, uid, uidLength) == 0) {
+      *capability = capabilityCache[i].capability;
+      tagStatsSelect(uid, uidLength, capability->name);
+      return true;
+    }
+  }
+
+  uint8_t command[1] = { NTAG_CMD_GET_VERSION };
+  uint8_t response[8];
+  uint8_t responseLength = sizeof(response);
+  bool versionRead = nfc->inDataExchange(command, sizeof(command), response, &responseLength) && responseLength >= 8;
+
+  const NtagCapability* known = versionRead ? findNtagCapability(response[2], response[6]) : nullptr;
+  if (known != nullptr) {
+    *capability = *known;
   } else {
-    // Conservative fallback
-    maxPages = 39;
-    Serial.println("Unknown tag type, using NTAG213 page limit as fallback");
+    // A NAK puts the tag back into IDLE state, select it again before reading the CC
+    uint8_t selectUid[7];
+    uint8_t selectUidLength;
+    if (!versionRead && !nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, selectUid, &selectUidLength, 100)) {
+      Serial.println("Tag lost during type detection");
+      return false;
+    }
+
+    // CC[2] contains the data area size in bytes / 8
+    uint8_t ccBuffer[4];
+    if (!nfc->ntag2xx_ReadPage(3, ccBuffer) || ccBuffer[2] == 0) {
+      Serial.println("Failed to read capability container");
+      return false;
+    }
+
+    capability->productType = versionRead ? response[2] : 0;
+    capability->storageSize = versionRead ? response[6] : 0;
+    capability->name = versionRead ? "UNKNOWN" : "ULTRALIGHT";
+    capability->lastUserPage = min(3 + ccBuffer[2] * 2, 225);
+    capability->fastRead = versionRead;
   }
-  
-  Serial.print("Maximum writable page: ");
-  Serial.println(maxPages);
-  return maxPages;
+
+  Serial.print("Detected: ");
+  Serial.print(capability->name);
+  Serial.print(" (user pages 4-");
+  Serial.print(capability->lastUserPage);
+  Serial.println(")");
+
+  NtagCapabilityCacheEntry& entry = capabilityCache[capabilityCacheNext];
+  memcpy(entry.uid, uid, uidLength);
+  entry.uidLength = uidLength;
+  entry.capability = *capability;
+  capabilityCacheNext = (capabilityCacheNext + 1) % NTAG_CAPABILITY_CACHE_SIZE;
+  if (capabilityCacheCount < NTAG_CAPABILITY_CACHE_SIZE) capabilityCacheCount++;
+
+  // Page reads of this tag use its statistics from here on
+  tagStatsSelect(uid, uidLength, capability->name);
+  return true;
 }
 
 bool initializeNdefStructure() {
@@ -278,7 +617,7 @@ bool initializeNdefStructure() {
     for (int i = 0; i < 8; i += 4) {
         memcpy(pageBuffer, &minimalNdef[i], 4);
         
-        if (!nfc.ntag2xx_WritePage(4 + (i / 4), pageBuffer)) {
+        if (!nfc->ntag2xx_WritePage(4 + (i / 4), pageBuffer)) {
             Serial.print("Fehler beim Initialisieren von Seite ");
             Serial.println(4 + (i / 4));
             return false;
@@ -303,26 +642,10 @@ bool initializeNdefStructure() {
 bool clearUserDataArea() {
     // IMPORTANT: Only clear user data pages, NOT configuration pages
     // NTAG layout: Pages 0-3 (header), 4-N (user data), N+1-N+3 (config) - NEVER touch config!
-    String tagType = detectNtagType();
-    
     // Calculate safe user data page ranges (NEVER touch config pages!)
-    uint16_t firstUserPage = 4;
-    uint16_t lastUserPage = 0;
-    
-    if (tagType == "NTAG213") {
-        lastUserPage = 39;  // Pages 40-42 are config - DO NOT TOUCH!
-        Serial.println("NTAG213: Sichere Löschung Seiten 4-39");
-    } else if (tagType == "NTAG215") {
-        lastUserPage = 129; // Pages 130-132 are config - DO NOT TOUCH!
-        Serial.println("NTAG215: Sichere Löschung Seiten 4-129");
-    } else if (tagType == "NTAG216") {
-        lastUserPage = 225; // Pages 226-228 are config - DO NOT TOUCH!
-        Serial.println("NTAG216: Sichere Löschung Seiten 4-225");
-    } else {
-        // Conservative fallback - only clear a small safe area
-        lastUserPage = 39;
-        Serial.println("UNKNOWN TAG: Konservative Löschung Seiten 4-39");
-    }
+    Serial.print(currentTag.name);
+    Serial.print(": Sichere Löschung Seiten 4-");
+    Serial.println(currentTag.lastUserPage);
     
     Serial.println("WARNUNG: Vollständiges Löschen kann Tag beschädigen!");
     Serial.println("Verwende stattdessen selective NDEF-Überschreibung...");
@@ -332,146 +655,125 @@ bool clearUserDataArea() {
     return initializeNdefStructure();
 }
 
-uint8_t ntag2xx_WriteNDEF(const char *payload) {
-  // Determine exact tag type and capabilities first
-  String tagType = detectNtagType();
-  uint16_t tagSize = readTagSize();
-  uint16_t availableUserData = getAvailableUserDataSize();
-  uint16_t maxWritablePage = getMaxUserDataPages();
-  
-  Serial.println("=== NFC TAG ANALYSIS ===");
-  Serial.print("Tag Type: ");Serial.println(tagType);
-  Serial.print("Total Tag Size: ");Serial.println(tagSize);
-  Serial.print("Available User Data: ");Serial.println(availableUserData);
-  Serial.print("Max Writable Page: ");Serial.println(maxWritablePage);
-  Serial.println("========================");
+// Progress of a write that stopped part way, e.g. because the tag left the field. Pages from 5 on
+// are written in order and page 4, which makes the record valid, last. committedPages counts the
+// image pages from page 5 on that are already on the tag.
+struct NfcWriteProgress {
+  uint8_t uid[7];
+  uint8_t uidLength;        // 0 = no interrupted write
+  uint32_t imageCrc;        // CRC32 of the TLV image being written
+  uint16_t committedPages;
+  bool tagLost;             // Write stopped because the tag did not answer any more
+  unsigned long updatedAt;
+};
 
-  // Perform additional tag validation by testing write boundaries
-  Serial.println("=== TAG VALIDATION ===");
-  uint8_t testBuffer[4] = {0x00, 0x00, 0x00, 0x00};
-  
-  // Test if we can actually read the max page
-  if (!nfc.ntag2xx_ReadPage(maxWritablePage, testBuffer)) {
-    Serial.print("WARNING: Cannot read declared max page ");
-    Serial.println(maxWritablePage);
-    
-    // Find actual maximum writable page by testing backwards with optimized approach
-    uint16_t actualMaxPage = maxWritablePage;
-    Serial.println("Searching for actual maximum writable page...");
-    
-    // Use binary search approach for faster page limit detection
-    uint16_t lowPage = 4;
-    uint16_t highPage = maxWritablePage;
-    uint16_t testAttempts = 0;
-    const uint16_t maxTestAttempts = 15; // Limit search attempts
-    
-    while (lowPage <= highPage && testAttempts < maxTestAttempts) {
-      uint16_t midPage = (lowPage + highPage) / 2;
-      testAttempts++;
-      
-      Serial.print("Testing page ");
-      Serial.print(midPage);
-      Serial.print(" (attempt ");
-      Serial.print(testAttempts);
-      Serial.print("/");
-      Serial.print(maxTestAttempts);
-      Serial.print(")... ");
-      
-      if (nfc.ntag2xx_ReadPage(midPage, testBuffer)) {
-        Serial.println("✓");
-        actualMaxPage = midPage;
-        lowPage = midPage + 1; // Search higher
-      } else {
-        Serial.println("❌");
-        highPage = midPage - 1; // Search lower
-      }
-      
-      // Small delay to prevent interface overload
-      vTaskDelay(5 / portTICK_PERIOD_MS);
-      yield();
-    }
-    
-    Serial.print("Found actual max readable page: ");
-    Serial.println(actualMaxPage);
-    Serial.print("Search completed in ");
-    Serial.print(testAttempts);
-    Serial.println(" attempts");
-    
-    maxWritablePage = actualMaxPage;
-  } else {
-    Serial.print("✓ Max page ");Serial.print(maxWritablePage);Serial.println(" is readable");
+static NfcWriteProgress nfcWriteProgress; // Only used by the NFC task
+
+bool isWriteProgressFor(const uint8_t* uid, uint8_t uidLength) {
+  return nfcWriteProgress.uidLength == uidLength && memcmp(nfcWriteProgress.uid, uid, uidLength) == 0 &&
+         millis() - nfcWriteProgress.updatedAt < NFC_WRITE_RESUME_TIMEOUT;
+}
+
+void recordWriteProgress(const uint8_t* uid, uint8_t uidLength, uint32_t imageCrc, uint16_t committedPages) {
+  memcpy(nfcWriteProgress.uid, uid, uidLength);
+  nfcWriteProgress.uidLength = uidLength;
+  nfcWriteProgress.imageCrc = imageCrc;
+  nfcWriteProgress.committedPages = committedPages;
+  nfcWriteProgress.tagLost = false;
+  nfcWriteProgress.updatedAt = millis();
+}
+
+// Selects the tag being written again, a missing or different tag marks the write as interrupted
+bool checkWriteTagPresent(const uint8_t* uid, uint8_t uidLength) {
+  uint8_t presentUid[7];
+  uint8_t presentUidLength;
+  if (checkTagPresence(presentUid, &presentUidLength) &&
+      presentUidLength == uidLength && memcmp(presentUid, uid, uidLength) == 0) {
+    return true;
   }
-  
-  // Calculate maximum available user data based on actual writable pages
-  uint16_t actualUserDataSize = (maxWritablePage - 3) * 4; // -3 because pages 0-3 are header
-  availableUserData = actualUserDataSize;
-  
-  Serial.print("Actual available user data: ");
-  Serial.print(actualUserDataSize);
-  Serial.println(" bytes");
-  Serial.println("========================");
 
-  uint8_t pageBuffer[4] = {0, 0, 0, 0};
-  Serial.println("Beginne mit dem Schreiben der NDEF-Nachricht...");
-  
-  // Figure out how long the string is
-  uint16_t payloadLen = strlen(payload);
-  Serial.print("Länge der Payload: ");
-  Serial.println(payloadLen);
-  
-  Serial.print("Payload: ");Serial.println(payload);
+  Serial.println("Tag hat das Feld verlassen");
+  nfcWriteProgress.tagLost = true;
+  return false;
+}
 
-  // MIME type for JSON
-  const char mimeType[] = "application/json";
-  uint8_t mimeTypeLen = strlen(mimeType);
-  
-  // Calculate NDEF record size
-  uint8_t ndefRecordHeaderSize = 3; // Header byte + Type Length + Payload Length (short record)
-  uint16_t ndefRecordSize = ndefRecordHeaderSize + mimeTypeLen + payloadLen;
-  
-  // Calculate TLV size - need to check if we need extended length format
-  uint8_t tlvHeaderSize;
-  uint16_t totalTlvSize;
-  
-  if (ndefRecordSize <= 254) {
-    // Standard TLV format: Tag (1) + Length (1) + Value (ndefRecordSize)
-    tlvHeaderSize = 2;
-    totalTlvSize = tlvHeaderSize + ndefRecordSize + 1; // +1 for terminator TLV
-  } else {
-    // Extended TLV format: Tag (1) + 0xFF + Length (2) + Value (ndefRecordSize)  
-    tlvHeaderSize = 4;
-    totalTlvSize = tlvHeaderSize + ndefRecordSize + 1; // +1 for terminator TLV
+// Writes one page. A NAK sends the tag back to IDLE, so it is selected again before the next
+// attempt. If it does not answer or another tag is in the field, the write stops.
+// The page is not read back here, verifyImagePages checks all written pages in one burst.
+bool writeTagPage(uint8_t pageNumber, uint8_t* pageBuffer, const uint8_t* uid, uint8_t uidLength) {
+  for (int writeAttempt = 0; writeAttempt < 3; writeAttempt++) {
+    if (nfc->ntag2xx_WritePage(pageNumber, pageBuffer)) {
+      return true;
+    }
+
+    Serial.print("Schreibversuch ");
+    Serial.print(writeAttempt + 1);
+    Serial.print("/3 für Seite ");
+    Serial.print(pageNumber);
+    Serial.println(" fehlgeschlagen");
+
+    if (writeAttempt < 2) {
+      vTaskDelay(50 / portTICK_PERIOD_MS); // Wait before retry
+
+      if (!checkWriteTagPresent(uid, uidLength)) break;
+    }
   }
 
-  Serial.print("NDEF Record Size: ");
-  Serial.println(ndefRecordSize);
-  Serial.print("Total TLV Size: ");
-  Serial.println(totalTlvSize);
+  Serial.print("FEHLER beim Schreiben der Seite ");
+  Serial.println(pageNumber);
+  return false;
+}
 
-  // Check if the message fits in the available user data space
-  if (totalTlvSize > availableUserData) {
-    Serial.println();
-    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
-    Serial.println("FEHLER: Payload zu groß für diesen Tag-Typ!");
-    Serial.print("Tag-Typ: ");Serial.println(tagType);
-    Serial.print("Benötigt: ");Serial.print(totalTlvSize);Serial.println(" Bytes");
-    Serial.print("Verfügbar: ");Serial.print(availableUserData);Serial.println(" Bytes");
-    Serial.print("Überschuss: ");Serial.print(totalTlvSize - availableUserData);Serial.println(" Bytes");
-    
-    if (tagType == "NTAG213") {
-      Serial.println("EMPFEHLUNG: Verwenden Sie einen NTAG215 (504 Bytes) oder NTAG216 (888 Bytes) Tag!");
-      Serial.println("Oder kürzen Sie die Payload um mindestens " + String(totalTlvSize - availableUserData) + " Bytes.");
+// Reads the pages back in FAST_READ bursts and compares them with the image. A page that differs
+// is written again, bytes behind the image keep what was read. Returns the number of rewritten
+// pages, -1 if the read or a rewrite failed.
+int16_t verifyImagePages(uint16_t firstPage, uint16_t lastPage, const uint8_t* tlvData, uint16_t totalBytes,
+                         const uint8_t* uid, uint8_t uidLength) {
+  uint8_t readBuffer[NTAG_FAST_READ_MAX_PAGES * 4];
+  int16_t rewritten = 0;
+
+  for (uint16_t chunkStart = firstPage; chunkStart <= lastPage; chunkStart += NTAG_FAST_READ_MAX_PAGES) {
+    uint16_t chunkPages = min((int)NTAG_FAST_READ_MAX_PAGES, (int)(lastPage - chunkStart + 1));
+    if (!ntag2xx_ReadPages(chunkStart, chunkPages, readBuffer)) {
+      Serial.println("❌ Verifikation: Seiten nicht lesbar");
+      checkWriteTagPresent(uid, uidLength);
+      return -1;
+    }
+
+    for (uint16_t i = 0; i < chunkPages; i++) {
+      uint16_t pageNumber = chunkStart + i;
+      uint16_t offset = (pageNumber - 4) * 4;
+      uint16_t bytesToCompare = min(4, (int)(totalBytes - offset));
+      uint8_t* readPage = &readBuffer[i * 4];
+      if (memcmp(readPage, &tlvData[offset], bytesToCompare) == 0) continue;
+
+      Serial.print("VERIFIKATIONSFEHLER auf Seite ");
+      Serial.print(pageNumber);
+      Serial.println(" - schreibe erneut");
+      memcpy(readPage, &tlvData[offset], bytesToCompare);
+      if (!writeTagPage(pageNumber, readPage, uid, uidLength)) return -1;
+      rewritten++;
     }
-    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
-    Serial.println();
-    
-    oledShowMessage("Tag zu klein für Payload");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
   }
+  return rewritten;
+}
 
-  Serial.println("✓ Payload passt in den Tag - Schreibvorgang wird fortgesetzt");
+// Verifies until a read-back finds no difference, gives up after NFC_WRITE_VERIFY_ROUNDS rewrites
+bool verifyAndRepairImage(uint16_t firstPage, uint16_t lastPage, const uint8_t* tlvData, uint16_t totalBytes,
+                          const uint8_t* uid, uint8_t uidLength) {
+  for (uint8_t round = 0; round <= NFC_WRITE_VERIFY_ROUNDS; round++) {
+    int16_t rewritten = verifyImagePages(firstPage, lastPage, tlvData, totalBytes, uid, uidLength);
+    if (rewritten < 0) return false;
+    if (rewritten == 0) return true;
+    nfcPagesWritten += rewritten;
+  }
+
+  Serial.println("❌ SCHREIBVORGANG/VERIFIKATION FEHLGESCHLAGEN!");
+  return false;
+}
 
+// Checks and if necessary resets the reader before a write, skipped when an interrupted write continues
+bool checkWriteInterface() {
   // STEP 1: NFC Interface Reset and Reinitialization
   Serial.println();
   Serial.println("=== SCHRITT 1: NFC-INTERFACE RESET UND NEUINITIALISIERUNG ===");
@@ -481,7 +783,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
   
   // Try to read capability container (which worked during detection)
   uint8_t ccTest[4];
-  bool ccReadable = nfc.ntag2xx_ReadPage(3, ccTest);
+  bool ccReadable = nfc->ntag2xx_ReadPage(3, ccTest);
   Serial.print("Capability Container (Seite 3) lesbar: ");
   Serial.println(ccReadable ? "✓" : "❌");
   
@@ -495,11 +797,11 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
     Serial.println("1. Neuinitialisierung des PN532...");
     
     // Reinitialize the PN532
-    nfc.begin();
+    beginPn532();
     vTaskDelay(500 / portTICK_PERIOD_MS); // Give it time to initialize
     
     // Check firmware version to ensure communication is working
-    uint32_t versiondata = nfc.getFirmwareVersion();
+    uint32_t versiondata = nfc->getFirmwareVersion();
     if (versiondata) {
       Serial.print("PN532 Firmware Version: 0x");
       Serial.println(versiondata, HEX);
@@ -508,12 +810,12 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
       Serial.println("❌ PN532 Kommunikation fehlgeschlagen");
       oledShowMessage("NFC Reset failed");
       vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
+      return false;
     }
     
     // Step 2: Reconfigure SAM
     Serial.println("2. SAM-Konfiguration...");
-    nfc.SAMConfig();
+    nfc->SAMConfig();
     vTaskDelay(200 / portTICK_PERIOD_MS);
     
     // Step 3: Re-detect the tag
@@ -527,7 +829,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
       Serial.print(attempts + 1);
       Serial.print("/5... ");
       
-      if (nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000)) {
+      if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000)) {
         Serial.println("✓");
         tagRedetected = true;
         break;
@@ -541,7 +843,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
       Serial.println("❌ Tag konnte nach Reset nicht wiedererkannt werden");
       oledShowMessage("Tag lost after reset");
       vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
+      return false;
     }
     
     Serial.println("✓ Tag erfolgreich wiedererkannt");
@@ -550,7 +852,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
     Serial.println("4. Test der Grundfunktionalität...");
     vTaskDelay(200 / portTICK_PERIOD_MS); // Give interface time to stabilize
     
-    ccReadable = nfc.ntag2xx_ReadPage(3, ccTest);
+    ccReadable = nfc->ntag2xx_ReadPage(3, ccTest);
     Serial.print("Capability Container nach Reset lesbar: ");
     Serial.println(ccReadable ? "✓" : "❌");
     
@@ -558,7 +860,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
       Serial.println("❌ NFC-Interface funktioniert nach Reset immer noch nicht");
       oledShowMessage("NFC still broken");
       vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
+      return false;
     }
     
     Serial.println("✓ NFC-Interface erfolgreich wiederhergestellt");
@@ -584,7 +886,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
   bool basicPagesReadable = true;
   
   for (uint8_t testPage = 0; testPage <= 6; testPage++) {
-    bool readable = nfc.ntag2xx_ReadPage(testPage, testData);
+    bool readable = nfc->ntag2xx_ReadPage(testPage, testData);
     Serial.print("Seite ");
     Serial.print(testPage);
     Serial.print(": ");
@@ -610,157 +912,25 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
     Serial.println("Tag oder Interface ist defekt");
     oledShowMessage("Tag/Interface defect");
     vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
+    return false;
   }
   
   Serial.println("✓ Alle kritischen Seiten sind lesbar");
   Serial.println("===================================================");
 
+  // STEP 3: Allow interface to stabilize before major write operation
   Serial.println();
-  Serial.println("=== SCHRITT 3: SCHREIBBEREITSCHAFTSTEST ===");
-  
-  // Test write capabilities before attempting the full write
-  Serial.println("Teste Schreibfähigkeiten des Tags...");
-  
-  uint8_t testPage[4] = {0xAA, 0xBB, 0xCC, 0xDD}; // Test pattern
-  uint8_t originalPage[4]; // Store original content
-  
-  // First, read original content of test page
-  if (!nfc.ntag2xx_ReadPage(10, originalPage)) {
-    Serial.println("FEHLER: Kann Testseite nicht lesen für Backup");
-    oledShowMessage("Test page read error");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  Serial.print("Original Inhalt Seite 10: ");
-  for (int i = 0; i < 4; i++) {
-    if (originalPage[i] < 0x10) Serial.print("0");
-    Serial.print(originalPage[i], HEX);
-    Serial.print(" ");
-  }
-  Serial.println();
-  
-  // Perform write test
-  if (!nfc.ntag2xx_WritePage(10, testPage)) {
-    Serial.println("FEHLER: Schreibtest fehlgeschlagen!");
-    Serial.println("Tag ist möglicherweise schreibgeschützt oder defekt");
-    
-    // Additional diagnostics
-    Serial.println("=== ERWEITERTE SCHREIBTEST-DIAGNOSE ===");
-    
-    // Check if tag is still present
-    uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t uidLength;
-    bool tagStillPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000);
-    Serial.print("Tag noch erkannt: ");
-    Serial.println(tagStillPresent ? "✓" : "❌");
-    
-    if (!tagStillPresent) {
-      Serial.println("URSACHE: Tag wurde während Schreibtest entfernt!");
-      oledShowMessage("Tag removed");
-    } else {
-      Serial.println("URSACHE: Tag ist vorhanden aber nicht beschreibbar");
-      Serial.println("Möglicherweise: Schreibschutz, Defekt, oder Interface-Problem");
-      oledShowMessage("Tag write protected?");
-    }
-    Serial.println("==========================================");
-    
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  // Verify test write
-  uint8_t readBack[4];
-  vTaskDelay(20 / portTICK_PERIOD_MS); // Wait for write to complete
-  
-  if (!nfc.ntag2xx_ReadPage(10, readBack)) {
-    Serial.println("FEHLER: Kann Testdaten nicht zurücklesen!");
-    oledShowMessage("Test verify failed");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  bool testSuccess = true;
-  for (int i = 0; i < 4; i++) {
-    if (readBack[i] != testPage[i]) {
-      testSuccess = false;
-      break;
-    }
-  }
-  
-  if (!testSuccess) {
-    Serial.println("FEHLER: Schreibtest fehlgeschlagen - Daten stimmen nicht überein!");
-    Serial.print("Geschrieben: ");
-    for (int i = 0; i < 4; i++) {
-      Serial.print(testPage[i], HEX); Serial.print(" ");
-    }
-    Serial.println();
-    Serial.print("Gelesen: ");
-    for (int i = 0; i < 4; i++) {
-      Serial.print(readBack[i], HEX); Serial.print(" ");
-    }
-    Serial.println();
-    return 0;
-  }
-  
-  // Restore original content
-  Serial.println("Stelle ursprünglichen Inhalt wieder her...");
-  if (!nfc.ntag2xx_WritePage(10, originalPage)) {
-    Serial.println("WARNUNG: Konnte ursprünglichen Inhalt nicht wiederherstellen!");
-  } else {
-    Serial.println("✓ Ursprünglicher Inhalt wiederhergestellt");
-  }
-  
-  Serial.println("✓ Schreibtest erfolgreich - Tag ist voll funktionsfähig");
-  Serial.println("======================================================");
-
-  // STEP 4: NDEF initialization with verification
-  Serial.println();
-  Serial.println("=== SCHRITT 4: NDEF-INITIALISIERUNG ===");
-  if (!initializeNdefStructure()) {
-    Serial.println("FEHLER: Konnte NDEF-Struktur nicht initialisieren!");
-    oledShowMessage("NDEF init failed");
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  // Verify NDEF initialization
-  uint8_t ndefCheck[8];
-  bool ndefVerified = true;
-  for (uint8_t page = 4; page < 6; page++) {
-    if (!nfc.ntag2xx_ReadPage(page, &ndefCheck[(page-4)*4])) {
-      ndefVerified = false;
-      break;
-    }
-  }
-  
-  if (ndefVerified) {
-    Serial.print("NDEF-Header nach Initialisierung: ");
-    for (int i = 0; i < 8; i++) {
-      if (ndefCheck[i] < 0x10) Serial.print("0");
-      Serial.print(ndefCheck[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.println();
-  }
-  
-  Serial.println("✓ NDEF-Struktur initialisiert und verifiziert");
-  Serial.println("==========================================");
-
-  // STEP 5: Allow interface to stabilize before major write operation
-  Serial.println();
-  Serial.println("=== SCHRITT 5: NFC-INTERFACE STABILISIERUNG ===");
+  Serial.println("=== SCHRITT 3: NFC-INTERFACE STABILISIERUNG ===");
   Serial.println("Stabilisiere NFC-Interface vor Hauptschreibvorgang...");
   
-  // Give the interface time to fully settle after NDEF initialization
+  // Give the interface time to fully settle after the read tests
   vTaskDelay(200 / portTICK_PERIOD_MS);
   
   // Test interface stability with a simple read
   uint8_t stabilityTest[4];
   bool interfaceStable = false;
   for (int attempts = 0; attempts < 3; attempts++) {
-    if (nfc.ntag2xx_ReadPage(4, stabilityTest)) {
+    if (nfc->ntag2xx_ReadPage(4, stabilityTest)) {
       Serial.print("Interface stability test ");
       Serial.print(attempts + 1);
       Serial.println("/3: ✓");
@@ -778,59 +948,84 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
     Serial.println("FEHLER: NFC-Interface ist nicht stabil genug für Schreibvorgang");
     oledShowMessage("NFC Interface unstable");
     vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
+    return false;
   }
   
   Serial.println("✓ NFC-Interface ist stabil - Schreibvorgang kann beginnen");
   Serial.println("=========================================================");
 
-  // Allocate memory for the complete TLV structure
-  uint8_t* tlvData = (uint8_t*) malloc(totalTlvSize);
-  if (tlvData == NULL) {
-    Serial.println("Fehler: Nicht genug Speicher für TLV-Daten vorhanden.");
-    oledShowMessage("Memory error");
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    return 0;
-  }
+  return true;
+}
 
-  // Build TLV structure
-  uint16_t offset = 0;
+uint8_t ntag2xx_WriteNDEF(nfcPayloadFormatType format, const uint8_t* payload, uint16_t payloadLen, const NtagCapability* tag,
+                          const uint8_t* uid, uint8_t uidLength) {
+  // Capabilities come from GET_VERSION, no probing of page limits needed
+  uint16_t availableUserData = ntagUserDataSize(*tag);
+  uint16_t maxWritablePage = tag->lastUserPage;
   
-  // TLV Header
-  tlvData[offset++] = 0x03; // NDEF Message TLV Tag
+  Serial.println("=== NFC TAG ANALYSIS ===");
+  Serial.print("Tag Type: ");Serial.println(tag->name);
+  Serial.print("Available User Data: ");Serial.println(availableUserData);
+  Serial.print("Max Writable Page: ");Serial.println(maxWritablePage);
+  Serial.println("========================");
+
+  uint8_t pageBuffer[4] = {0, 0, 0, 0};
+  Serial.println("Beginne mit dem Schreiben der NDEF-Nachricht...");
   
-  if (ndefRecordSize <= 254) {
-    // Standard length format
-    tlvData[offset++] = (uint8_t)ndefRecordSize;
-  } else {
-    // Extended length format
-    tlvData[offset++] = 0xFF;
-    tlvData[offset++] = (uint8_t)(ndefRecordSize >> 8);  // High byte
-    tlvData[offset++] = (uint8_t)(ndefRecordSize & 0xFF); // Low byte
-  }
+  Serial.print("Länge der Payload: ");
+  Serial.println(payloadLen);
+  bool cbor = format == NFC_FORMAT_CBOR;
+  Serial.print("MIME-Typ: ");Serial.println(cbor ? NDEF_MIME_CBOR : NDEF_MIME_JSON);
 
-  // NDEF Record Header
-  tlvData[offset++] = 0xD2; // NDEF Record Header (TNF=0x2:MIME Media + SR + ME + MB)
-  tlvData[offset++] = mimeTypeLen; // Type Length
-  tlvData[offset++] = (uint8_t)payloadLen; // Payload Length (short record format)
+  // Size of the complete TLV structure (record uses the long format above 255 bytes payload)
+  // including the checksum TLV in front of the message
+  uint16_t totalTlvSize = cbor ? NdefCborTemplate::size(payloadLen) : NdefJsonTemplate::size(payloadLen);
 
-  // MIME Type
-  memcpy(&tlvData[offset], mimeType, mimeTypeLen);
-  offset += mimeTypeLen;
+  Serial.print("Total TLV Size: ");
+  Serial.println(totalTlvSize);
 
-  // JSON Payload
-  memcpy(&tlvData[offset], payload, payloadLen);
-  offset += payloadLen;
+  // Check if the message fits in the available user data space
+  if (totalTlvSize > availableUserData) {
+    Serial.println();
+    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
+    Serial.println("FEHLER: Payload zu groß für diesen Tag-Typ!");
+    Serial.print("Tag-Typ: ");Serial.println(tag->name);
+    Serial.print("Benötigt: ");Serial.print(totalTlvSize);Serial.println(" Bytes");
+    Serial.print("Verfügbar: ");Serial.print(availableUserData);Serial.println(" Bytes");
+    Serial.print("Überschuss: ");Serial.print(totalTlvSize - availableUserData);Serial.println(" Bytes");
+    
+    if (maxWritablePage < 129) {
+      Serial.println("EMPFEHLUNG: Verwenden Sie einen NTAG215 (504 Bytes) oder NTAG216 (888 Bytes) Tag!");
+      Serial.println("Oder kürzen Sie die Payload um mindestens " + String(totalTlvSize - availableUserData) + " Bytes.");
+    }
+    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
+    Serial.println();
+    
+    oledShowMessage("Tag zu klein für Payload");
+    vTaskDelay(3000 / portTICK_PERIOD_MS);
+    return 0;
+  }
 
-  // Terminator TLV
-  tlvData[offset] = 0xFE;
+  Serial.println("✓ Payload passt in den Tag - Schreibvorgang wird fortgesetzt");
 
+  // Build TLV structure from the prebuilt header of the record type, it fits the static buffer
+  // because it fits the tag. The checksum lets a later read validate the tag cache from the first pages.
+  uint8_t* tlvData = nfcTlvBuffer;
+  uint32_t checksum = tagCacheCrc32(payload, payloadLen);
+  uint16_t totalBytes = cbor ? NdefCborTemplate::encode(checksum, payload, payloadLen, tlvData, sizeof(nfcTlvBuffer))
+                             : NdefJsonTemplate::encode(checksum, payload, payloadLen, tlvData, sizeof(nfcTlvBuffer));
+  if (totalBytes == 0) {
+    Serial.println("Fehler: TLV-Daten konnten nicht erstellt werden.");
+    oledShowMessage("Memory error");
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    return 0;
+  }
   Serial.print("Gesamt-TLV-Länge: ");
-  Serial.println(offset + 1);
+  Serial.println(totalBytes);
 
   // Debug: Print first 64 bytes of TLV data
   Serial.println("TLV Daten (erste 64 Bytes):");
-  for (int i = 0; i < min((int)(offset + 1), 64); i++) {
+  for (int i = 0; i < min((int)totalBytes, 64); i++) {
     if (tlvData[i] < 0x10) Serial.print("0");
     Serial.print(tlvData[i], HEX);
     Serial.print(" ");
@@ -838,164 +1033,140 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
   }
   Serial.println();
 
-  // Write data to tag pages (starting from page 4)
-  uint16_t bytesWritten = 0;
-  uint8_t pageNumber = 4;
-  uint16_t totalBytes = offset + 1;
+  uint16_t totalPages = (totalBytes + 3) / 4;
+  uint16_t lastPage = 3 + totalPages;
+  uint32_t imageCrc = tagCacheCrc32(tlvData, totalBytes);
+
+  // Page 4 holds the first TLV, the one that leads a reader to the message. While the other pages
+  // change it is an empty message, so a tag lifted half-written reads as empty instead of a broken record.
+  uint8_t headerPage[4];
+  uint8_t emptyHeaderPage[4] = { NDEF_TLV_MESSAGE, 0x00, NDEF_TLV_TERMINATOR, 0x00 };
+  memcpy(headerPage, tlvData, 4);
+
+  // Same tag and image as an interrupted write: continue behind the last committed page
+  uint32_t writeStartedAt = micros();
+  bool resume = isWriteProgressFor(uid, uidLength) && nfcWriteProgress.imageCrc == imageCrc;
+  uint16_t firstPage = resume ? 5 + nfcWriteProgress.committedPages : 5;
+  if (resume) {
+    Serial.print("Setze unterbrochenen Schreibvorgang fort ab Seite ");
+    Serial.println(firstPage);
+  } else if (!checkWriteInterface()) {
+    return 0;
+  }
+  uint32_t checkDoneAt = micros();
+
+  // Read the current content in bulk so only pages that differ from the new image get written
+  uint8_t* currentData = nfcCurrentPages;
+  bool currentDataValid = false;
+  if (resume) {
+    // Page 4 still has to carry the empty message, otherwise the tag was written in between
+    if (ntag2xx_ReadPages(4, 1, currentData) && memcmp(currentData, emptyHeaderPage, 4) == 0) {
+      currentDataValid = firstPage > lastPage ||
+                         ntag2xx_ReadPages(firstPage, lastPage - firstPage + 1, &currentData[(firstPage - 4) * 4]);
+    } else {
+      Serial.println("Tag wurde seit dem Abbruch verändert - Schreibvorgang beginnt von vorn");
+      resume = false;
+      firstPage = 5;
+    }
+  }
+  if (!resume) {
+    currentDataValid = ntag2xx_ReadPages(4, totalPages, currentData);
+  }
+  if (!currentDataValid) {
+    Serial.println("WARNUNG: Aktueller Tag-Inhalt nicht lesbar - alle Seiten werden geschrieben");
+  }
+  uint32_t readDoneAt = micros();
+
+  nfcPagesWritten = 0;
+  nfcPagesSkipped = firstPage - 5;
+  bool headerCleared = resume || (currentDataValid && memcmp(currentData, emptyHeaderPage, 4) == 0);
 
   Serial.println();
-  Serial.println("=== SCHRITT 6: SCHREIBE NEUE NDEF-DATEN ===");
-  Serial.print("Schreibe ");
+  Serial.println("=== SCHRITT 4: SCHREIBE GEÄNDERTE NDEF-SEITEN ===");
+  Serial.print("Vergleiche ");
   Serial.print(totalBytes);
   Serial.print(" Bytes in ");
-  Serial.print((totalBytes + 3) / 4); // Round up division
+  Serial.print(totalPages);
   Serial.println(" Seiten...");
 
-  while (bytesWritten < totalBytes && pageNumber <= maxWritablePage) {
-    // Additional safety check before writing each page
-    if (pageNumber > maxWritablePage) {
-      Serial.print("STOP: Reached maximum writable page ");
-      Serial.println(maxWritablePage);
-      break;
-    }
-    
-    // Clear page buffer
-    memset(pageBuffer, 0, 4);
-    
-    // Calculate how many bytes to write to this page
-    uint16_t bytesToWrite = min(4, (int)(totalBytes - bytesWritten));
-    
-    // Copy data to page buffer
-    memcpy(pageBuffer, &tlvData[bytesWritten], bytesToWrite);
-
-    // Write page to tag with retry mechanism
-    bool writeSuccess = false;
-    for (int writeAttempt = 0; writeAttempt < 3; writeAttempt++) {
-      if (nfc.ntag2xx_WritePage(pageNumber, pageBuffer)) {
-        writeSuccess = true;
-        break;
-      } else {
-        Serial.print("Schreibversuch ");
-        Serial.print(writeAttempt + 1);
-        Serial.print("/3 für Seite ");
-        Serial.print(pageNumber);
-        Serial.println(" fehlgeschlagen");
-        
-        if (writeAttempt < 2) {
-          vTaskDelay(50 / portTICK_PERIOD_MS); // Wait before retry
-        }
-      }
-    }
+  for (uint16_t pageNumber = firstPage; pageNumber <= lastPage; pageNumber++) {
+    uint16_t offset = (pageNumber - 4) * 4;
+    uint16_t bytesToWrite = min(4, (int)(totalBytes - offset));
+    uint8_t* currentPage = currentDataValid ? &currentData[offset] : NULL;
 
-    if (!writeSuccess) {
-      Serial.print("FEHLER beim Schreiben der Seite ");
-      Serial.println(pageNumber);
-      Serial.print("Möglicherweise Page-Limit erreicht für ");
-      Serial.println(tagType);
-      Serial.print("Erwartetes Maximum: ");
-      Serial.println(maxWritablePage);
-      Serial.print("Tatsächliches Maximum scheint niedriger zu sein!");
-      
-      // Update max page for future operations
-      if (pageNumber > 4) {
-        Serial.print("Setze neues Maximum auf Seite ");
-        Serial.println(pageNumber - 1);
-      }
-      
-      free(tlvData);
-      return 0;
+    // Bytes behind the image keep their current content
+    if (currentPage != NULL) {
+      memcpy(pageBuffer, currentPage, 4);
+    } else {
+      memset(pageBuffer, 0, 4);
     }
+    memcpy(pageBuffer, &tlvData[offset], bytesToWrite);
 
-    // IMMEDIATE verification after each write - this is critical!
-    Serial.print("Verifiziere Seite ");
-    Serial.print(pageNumber);
-    Serial.print("... ");
-    
-    uint8_t verifyBuffer[4];
-    vTaskDelay(20 / portTICK_PERIOD_MS); // Increased delay before verification
-    
-    // Verification with retry mechanism
-    bool verifySuccess = false;
-    for (int verifyAttempt = 0; verifyAttempt < 3; verifyAttempt++) {
-      if (nfc.ntag2xx_ReadPage(pageNumber, verifyBuffer)) {
-        bool writeMatches = true;
-        for (int i = 0; i < bytesToWrite; i++) {
-          if (verifyBuffer[i] != pageBuffer[i]) {
-            writeMatches = false;
-            Serial.println();
-            Serial.print("VERIFIKATIONSFEHLER bei Byte ");
-            Serial.print(i);
-            Serial.print(" - Erwartet: 0x");
-            Serial.print(pageBuffer[i], HEX);
-            Serial.print(", Gelesen: 0x");
-            Serial.println(verifyBuffer[i], HEX);
-            break;
-          }
-        }
-        
-        if (writeMatches) {
-          verifySuccess = true;
-          break;
-        } else if (verifyAttempt < 2) {
-          Serial.print("Verifikationsversuch ");
-          Serial.print(verifyAttempt + 1);
-          Serial.println("/3 fehlgeschlagen, wiederhole...");
-          vTaskDelay(30 / portTICK_PERIOD_MS);
-        }
-      } else {
-        Serial.print("Verifikations-Read-Versuch ");
-        Serial.print(verifyAttempt + 1);
-        Serial.println("/3 fehlgeschlagen");
-        if (verifyAttempt < 2) {
-          vTaskDelay(30 / portTICK_PERIOD_MS);
-        }
-      }
+    // Unchanged page: nothing to write or verify
+    if (currentPage != NULL && memcmp(currentPage, pageBuffer, 4) == 0) {
+      nfcPagesSkipped++;
+      continue;
     }
-    
-    if (!verifySuccess) {
-      Serial.println("❌ SCHREIBVORGANG/VERIFIKATION FEHLGESCHLAGEN!");
-      free(tlvData);
-      return 0;
-    } else {
-      Serial.println("✓");
+
+    if (!headerCleared) {
+      if (!writeTagPage(4, emptyHeaderPage, uid, uidLength)) return 0;
+      nfcPagesWritten++;
+      headerCleared = true;
     }
 
-    Serial.print("Seite ");
-    Serial.print(pageNumber);
-    Serial.print(" ✓: ");
-    for (int i = 0; i < 4; i++) {
-      if (pageBuffer[i] < 0x10) Serial.print("0");
-      Serial.print(pageBuffer[i], HEX);
-      Serial.print(" ");
+    // Pages before this one are on the tag, a failure below leaves the progress for a resume
+    recordWriteProgress(uid, uidLength, imageCrc, pageNumber - 5);
+    if (!writeTagPage(pageNumber, pageBuffer, uid, uidLength)) {
+      Serial.print("Fortschritt gespeichert, ");
+      Serial.print(pageNumber - 5);
+      Serial.println(" Seiten hinter dem Header sind geschrieben");
+      return 0;
     }
-    Serial.println();
+    nfcPagesWritten++;
 
-    bytesWritten += bytesToWrite;
-    pageNumber++;
-    
     yield();
-    vTaskDelay(10 / portTICK_PERIOD_MS); // Slightly increased delay between page writes
   }
+  uint32_t writeDoneAt = micros();
 
-  free(tlvData);
-  
-  if (bytesWritten < totalBytes) {
-    Serial.println("WARNUNG: Nicht alle Daten konnten geschrieben werden!");
-    Serial.print("Geschrieben: ");
-    Serial.print(bytesWritten);
-    Serial.print(" von ");
-    Serial.print(totalBytes);
-    Serial.println(" Bytes");
-    Serial.print("Gestoppt bei Seite: ");
-    Serial.println(pageNumber - 1);
-    return 0;
+  // One read-back of everything behind the header, written in this or an interrupted run
+  if (headerCleared) {
+    recordWriteProgress(uid, uidLength, imageCrc, totalPages - 1);
+    if (!verifyAndRepairImage(5, lastPage, tlvData, totalBytes, uid, uidLength)) return 0;
   }
-  
+  uint32_t verifyDoneAt = micros();
+
+  // Page 4 last: the new record becomes valid with a single page write
+  if (headerCleared || !currentDataValid || memcmp(currentData, headerPage, 4) != 0) {
+    if (!writeTagPage(4, headerPage, uid, uidLength) ||
+        !verifyAndRepairImage(4, 4, tlvData, totalBytes, uid, uidLength)) {
+      return 0;
+    }
+    nfcPagesWritten++;
+  } else {
+    nfcPagesSkipped++;
+  }
+  uint32_t headerDoneAt = micros();
+
+  if (isWriteProgressFor(uid, uidLength)) nfcWriteProgress.uidLength = 0;
+  uint16_t bytesWritten = totalBytes;
+  uint8_t pageNumber = lastPage + 1;
+
   Serial.println();
   Serial.println("✓ NDEF-Nachricht erfolgreich geschrieben!");
-  Serial.print("✓ Tag-Typ: ");Serial.println(tagType);
+  Serial.print("✓ Tag-Typ: ");Serial.println(tag->name);
   Serial.print("✓ Insgesamt ");Serial.print(bytesWritten);Serial.println(" Bytes geschrieben");
   Serial.print("✓ Verwendete Seiten: 4-");Serial.println(pageNumber - 1);
+  Serial.print("✓ Seiten geschrieben: ");Serial.print(nfcPagesWritten);
+  Serial.print(", übersprungen: ");Serial.println(nfcPagesSkipped);
+  nfcLatencyRecord(NFC_PHASE_WRITE_CHECK, checkDoneAt - writeStartedAt);
+  nfcLatencyRecord(NFC_PHASE_WRITE_READ, readDoneAt - checkDoneAt);
+  nfcLatencyRecord(NFC_PHASE_WRITE_PAGES, writeDoneAt - readDoneAt);
+  nfcLatencyRecord(NFC_PHASE_WRITE_VERIFY, verifyDoneAt - writeDoneAt);
+  nfcLatencyRecord(NFC_PHASE_WRITE_HEADER, headerDoneAt - verifyDoneAt);
+  Serial.printf("✓ Dauer (ms): Prüfung %lu, Lesen %lu, Schreiben %lu, Verifikation %lu, Header %lu\n",
+                (unsigned long)(checkDoneAt - writeStartedAt) / 1000, (unsigned long)(readDoneAt - checkDoneAt) / 1000,
+                (unsigned long)(writeDoneAt - readDoneAt) / 1000, (unsigned long)(verifyDoneAt - writeDoneAt) / 1000,
+                (unsigned long)(headerDoneAt - verifyDoneAt) / 1000);
   Serial.print("✓ Speicher-Auslastung: ");
   Serial.print((bytesWritten * 100) / availableUserData);
   Serial.println("%");
@@ -1003,7 +1174,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
   
   // CRITICAL: Allow NFC interface to stabilize after write operation
   Serial.println();
-  Serial.println("=== SCHRITT 7: NFC-INTERFACE STABILISIERUNG NACH SCHREIBVORGANG ===");
+  Serial.println("=== SCHRITT 5: NFC-INTERFACE STABILISIERUNG NACH SCHREIBVORGANG ===");
   Serial.println("Stabilisiere NFC-Interface nach Schreibvorgang...");
   
   // Give the tag and interface time to settle after write operation
@@ -1018,7 +1189,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
     Serial.print(stabilityAttempt + 1);
     Serial.print("/5... ");
     
-    if (nfc.ntag2xx_ReadPage(3, postWriteTest)) { // Read capability container
+    if (nfc->ntag2xx_ReadPage(3, postWriteTest)) { // Read capability container
       Serial.println("✓");
       interfaceResponsive = true;
       break;
@@ -1032,7 +1203,7 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
         // Try to re-establish communication with a simple tag presence check
         uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
         uint8_t uidLength;
-        bool tagStillPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000);
+        bool tagStillPresent = nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000);
         Serial.print("Tag presence check: ");
         Serial.println(tagStillPresent ? "✓" : "❌");
         
@@ -1056,237 +1227,203 @@ uint8_t ntag2xx_WriteNDEF(const char *payload) {
   return 1;
 }
 
-bool decodeNdefAndReturnJson(const byte* encodedMessage, String uidString) {
-  oledShowProgressBar(1, octoEnabled?5:4, "Reading", "Decoding data");
+// Decodes the JSON or CBOR spool record into doc and sets nfcJsonData
+bool decodeSpoolRecord(const byte* encodedMessage, uint16_t length, JsonDocument& doc) {
+  // Locate the record in a single pass over the buffer
+  NdefRecordView record;
+  bool isJson = ndefFindJsonRecord(encodedMessage, length, &record);
+  if (!isJson && !ndefFindMimeRecord(encodedMessage, length, NDEF_MIME_CBOR, &record))
+  {
+    Serial.println("No NDEF JSON or CBOR record found in tag data");
+    return false;
+  }
 
-  // Debug: Print first 32 bytes of the raw data
-  Serial.println("Raw NDEF data (first 32 bytes):");
-  for (int i = 0; i < 32; i++) {
-    if (encodedMessage[i] < 0x10) Serial.print("0");
-    Serial.print(encodedMessage[i], HEX);
-    Serial.print(" ");
-    if ((i + 1) % 16 == 0) Serial.println();
+  if (record.availableLength < record.payloadLength)
+  {
+    Serial.print("Invalid NDEF structure - payload extends beyond read data: ");
+    Serial.print(record.availableLength);
+    Serial.print(" of ");
+    Serial.println(record.payloadLength);
+    return false;
   }
-  Serial.println();
 
-  // Look for the NDEF TLV structure starting from the beginning
-  int tlvOffset = 0;
-  bool foundNdefTlv = false;
-  
-  // Search for NDEF TLV (0x03) in the first few bytes
-  for (int i = 0; i < 16; i++) {
-    if (encodedMessage[i] == 0x03) {
-      tlvOffset = i;
-      foundNdefTlv = true;
-      Serial.print("Found NDEF TLV at offset: ");
-      Serial.println(tlvOffset);
-      break;
+  if (!isJson)
+  {
+    nfcJsonData[0] = '\0';
+    if (!spoolCborDecode(record.payload, record.payloadLength, doc))
+    {
+      Serial.println("Fehler beim Verarbeiten des CBOR-Datensatzes");
+      return false;
+    }
+
+    // The web interface and Spoolman keep working with JSON
+    if (measureJson(doc) >= sizeof(nfcJsonData))
+    {
+      Serial.println("CBOR-Datensatz ist als JSON zu lang");
+      return false;
     }
+    serializeJson(doc, nfcJsonData, sizeof(nfcJsonData));
+    Serial.print("CBOR length: ");
+    Serial.println(record.payloadLength);
+    return true;
   }
 
-  if (!foundNdefTlv) {
-    Serial.println("No NDEF TLV found in tag data");
+  const char* json = (const char*)record.payload;
+  size_t jsonLength = jsonObjectLength(json, record.payloadLength);
+  if (jsonLength == 0)
+  {
+    Serial.println("WARNING: JSON payload appears to be truncated!");
     return false;
   }
 
-  // Get the NDEF message length from TLV
-  uint16_t ndefMessageLength = 0;
-  int ndefRecordOffset = 0;
-  
-  if (encodedMessage[tlvOffset + 1] == 0xFF) {
-    // Extended length format: next 2 bytes contain the actual length
-    ndefMessageLength = (encodedMessage[tlvOffset + 2] << 8) | encodedMessage[tlvOffset + 3];
-    ndefRecordOffset = tlvOffset + 4; // Skip TLV tag + 0xFF + 2 length bytes
-    Serial.print("NDEF Message Length (extended): ");
-  } else {
-    // Standard length format: single byte contains the length
-    ndefMessageLength = encodedMessage[tlvOffset + 1];
-    ndefRecordOffset = tlvOffset + 2; // Skip TLV tag + 1 length byte
-    Serial.print("NDEF Message Length (standard): ");
-  }
-  Serial.println(ndefMessageLength);
+  Serial.print("JSON length: ");
+  Serial.println(jsonLength);
 
-  // Get pointer to NDEF record
-  const byte* ndefRecord = &encodedMessage[ndefRecordOffset];
-  
-  // Parse NDEF record header
-  byte recordHeader = ndefRecord[0];
-  byte typeLength = ndefRecord[1];
-  
-  Serial.print("NDEF Record Header: 0x");
-  Serial.println(recordHeader, HEX);
-  Serial.print("Type Length: ");
-  Serial.println(typeLength);
-
-  // Determine payload length (can be 1 or 4 bytes depending on SR flag)
-  uint32_t payloadLength = 0;
-  byte payloadLengthBytes = 1;
-  byte payloadLengthOffset = 2;
-  
-  // Check if Short Record (SR) flag is set (bit 4)
-  if (recordHeader & 0x10) { // SR flag
-    payloadLength = ndefRecord[2];
-    payloadLengthBytes = 1;
-    payloadLengthOffset = 2;
-  } else {
-    // Long record format (4 bytes for payload length)
-    payloadLength = (ndefRecord[2] << 24) | (ndefRecord[3] << 16) | 
-                   (ndefRecord[4] << 8) | ndefRecord[5];
-    payloadLengthBytes = 4;
-    payloadLengthOffset = 2;
+  nfcJsonData[0] = '\0';
+  DeserializationError error = deserializeJson(doc, json, jsonLength);
+  if (error) 
+  {
+    Serial.println("Fehler beim Verarbeiten des JSON-Dokuments");
+    Serial.print("deserializeJson() failed: ");
+    Serial.println(error.f_str());
+    return false;
   }
 
-  Serial.print("Payload Length: ");
-  Serial.println(payloadLength);
-  Serial.print("Payload Length Bytes: ");
-  Serial.println(payloadLengthBytes);
+  // jsonLength never exceeds the record, which fits the buffer
+  memcpy(nfcJsonData, json, jsonLength);
+  nfcJsonData[jsonLength] = '\0';
+  return true;
+}
+
+// Relocation session: a location tag is scanned once, every spool scanned after it is moved
+// there. Scanning the same location tag again or a pause of NFC_RELOCATION_SESSION_TIMEOUT ends it.
+struct NfcRelocationSession {
+  char location[SPOOLMAN_LOCATION_MAX_LENGTH];  // Empty while no session runs
+  uint32_t lastSpoolId;       // A spool left on the reader is moved only once
+  uint16_t spools;
+  unsigned long lastScanAt;
+};
+
+static NfcRelocationSession relocationSession; // Only used by the NFC task
+
+static void endRelocationSession(const char* reason) {
+  Serial.printf("Umlagerung nach %s beendet (%s), %u Spulen\n", relocationSession.location, reason, relocationSession.spools);
+  relocationSession.location[0] = '\0';
+}
+
+static bool relocationSessionActive() {
+  if (relocationSession.location[0] == '\0') return false;
+  if (millis() - relocationSession.lastScanAt < NFC_RELOCATION_SESSION_TIMEOUT) return true;
+  endRelocationSession("Zeitüberschreitung");
+  return false;
+}
 
-  // Check for ID field (if IL flag is set)
-  byte idLength = 0;
-  if (recordHeader & 0x08) { // IL flag
-    idLength = ndefRecord[payloadLengthOffset + payloadLengthBytes];
-    Serial.print("ID Length: ");
-    Serial.println(idLength);
+static void relocateSpool(uint32_t spoolId) {
+  if (spoolId == relocationSession.lastSpoolId) return;
+  if (updateSpoolLocation(spoolId, relocationSession.location)) {
+    relocationSession.lastSpoolId = spoolId;
+    relocationSession.spools++;
   }
+}
 
-  // Calculate offset to payload
-  byte payloadOffset = 1 + 1 + payloadLengthBytes + typeLength + idLength;
-  
-  Serial.print("Calculated payload offset: ");
-  Serial.println(payloadOffset);
-
-  // Verify we have enough data
-  if (payloadOffset + payloadLength > ndefMessageLength) {
-    Serial.println("Invalid NDEF structure - payload extends beyond message");
-    Serial.print("Payload offset + length: ");
-    Serial.print(payloadOffset + payloadLength);
-    Serial.print(", NDEF message length: ");
-    Serial.println(ndefMessageLength);
-    return false;
+static void showRelocationSession(bool done) {
+  char status[SPOOLMAN_LOCATION_MAX_LENGTH + 16];
+  const char* unit = relocationSession.spools == 1 ? "spool" : "spools";
+  if (done) {
+    snprintf(status, sizeof(status), "Done: %u %s", relocationSession.spools, unit);
+  } else {
+    snprintf(status, sizeof(status), "%s: %u %s", relocationSession.location, relocationSession.spools, unit);
   }
+  oledShowProgressBar(1, 1, done ? "Loc. Tag" : "Relocating", status);
+}
 
-  // Print the record type for debugging
-  Serial.print("Record Type: ");
-  for (int i = 0; i < typeLength; i++) {
-    Serial.print((char)ndefRecord[1 + 1 + payloadLengthBytes + i]);
+// A known spool was read. Outside a session it waits for a location tag, during one it is moved right away.
+static void spoolScanned(uint32_t spoolId) {
+  setActiveSpool(spoolId);
+  if (!relocationSessionActive()) {
+    lastSpoolId = spoolId;
+    return;
   }
-  Serial.println();
 
-  nfcJsonData = "";
+  lastSpoolId = 0;
+  relocateSpool(spoolId);
+  relocationSession.lastScanAt = millis();
+  showRelocationSession(false);
+}
 
-  // Extract JSON payload with validation
-  uint32_t actualJsonLength = 0;
-  for (uint32_t i = 0; i < payloadLength; i++) {
-    byte currentByte = ndefRecord[payloadOffset + i];
-    
-    // Stop at null terminator or if we find the end of JSON
-    if (currentByte == 0x00) {
-      Serial.print("Found null terminator at position: ");
-      Serial.println(i);
-      break;
-    }
-    
-    // Only add printable characters and common JSON characters
-    if (currentByte >= 32 && currentByte <= 126) {
-      nfcJsonData += (char)currentByte;
-      actualJsonLength++;
-    } else {
-      Serial.print("Skipping non-printable byte at position ");
-      Serial.print(i);
-      Serial.print(": 0x");
-      Serial.println(currentByte, HEX);
-    }
-    
-    // Check if we've reached the end of a JSON object
-    if (currentByte == '}') {
-      // Count opening and closing braces to detect complete JSON
-      int braceCount = 0;
-      for (uint32_t j = 0; j <= i; j++) {
-        if (ndefRecord[payloadOffset + j] == '{') braceCount++;
-        else if (ndefRecord[payloadOffset + j] == '}') braceCount--;
-      }
-      
-      if (braceCount == 0) {
-        Serial.print("Found complete JSON object at position: ");
-        Serial.println(i);
-        actualJsonLength = i + 1;
-        break;
-      }
-    }
+// location is plain text: jsonCopyValue, the tag cache and ArduinoJson all resolve the JSON escapes
+static void locationScanned(const char* location) {
+  Serial.print("Location Tag found: ");
+  Serial.println(location);
+
+  if (!spoolmanConnected) {
+    oledShowProgressBar(octoEnabled?5:4, octoEnabled?5:4, "Failure!", "Spoolman unavailable");
+    return;
   }
 
-  Serial.print("Actual JSON length extracted: ");
-  Serial.println(actualJsonLength);
-  Serial.print("Total nfcJsonData length: ");
-  Serial.println(nfcJsonData.length());
-  Serial.println("=== DECODED JSON DATA START ===");
-  Serial.println(nfcJsonData);
-  Serial.println("=== DECODED JSON DATA END ===");
-  
-  // Check if JSON was truncated
-  if (nfcJsonData.length() < payloadLength && !nfcJsonData.endsWith("}")) {
-    Serial.println("WARNING: JSON payload appears to be truncated!");
-    Serial.print("Expected payload length: ");
-    Serial.println(payloadLength);
-    Serial.print("Actual extracted length: ");
-    Serial.println(nfcJsonData.length());
+  if (relocationSessionActive() && strcmp(relocationSession.location, location) == 0) {
+    showRelocationSession(true);
+    endRelocationSession("Tag erneut gescannt");
+    return;
   }
-  
-  // Trim any trailing whitespace or invalid characters
-  nfcJsonData.trim();
+  if (relocationSessionActive()) endRelocationSession("neuer Lagerort");
+
+  strlcpy(relocationSession.location, location, sizeof(relocationSession.location));
+  relocationSession.lastSpoolId = 0;
+  relocationSession.spools = 0;
+  relocationSession.lastScanAt = millis();
+  Serial.printf("Umlagerung nach %s gestartet\n", relocationSession.location);
+
+  // The spool scanned right before the location tag is moved as well
+  if (lastSpoolId != 0) {
+    relocateSpool(lastSpoolId);
+    lastSpoolId = 0;
+  }
+  showRelocationSession(false);
+}
+
+bool decodeNdefAndReturnJson(const byte* encodedMessage, uint16_t length, const char* uidString) {
+  oledShowProgressBar(1, octoEnabled?5:4, "Reading", "Decoding data");
 
   // JSON-Dokument verarbeiten
   JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, nfcJsonData);
-  if (error) 
+  if (!decodeSpoolRecord(encodedMessage, length, doc)) 
   {
-    nfcJsonData = "";
-    Serial.println("Fehler beim Verarbeiten des JSON-Dokuments");
-    Serial.print("deserializeJson() failed: ");
-    Serial.println(error.f_str());
     return false;
   } 
   else 
   {
+    Serial.println("=== DECODED JSON DATA START ===");
+    Serial.println(nfcJsonData);
+    Serial.println("=== DECODED JSON DATA END ===");
+
     // If spoolman is unavailable, there is no point in continuing
     if(spoolmanConnected){
       // Sende die aktualisierten AMS-Daten an alle WebSocket-Clients
       Serial.println("JSON-Dokument erfolgreich verarbeitet");
-      Serial.println(doc.as<String>());
       if (doc["sm_id"].is<String>() && doc["sm_id"] != "" && doc["sm_id"] != "0")
       {
         oledShowProgressBar(2, octoEnabled?5:4, "Spool Tag", "Weighing");
         Serial.println("SPOOL-ID gefunden: " + doc["sm_id"].as<String>());
-        activeSpoolId = doc["sm_id"].as<String>();
-        lastSpoolId = activeSpoolId;
+        spoolScanned(doc["sm_id"].as<String>().toInt());
       }
       else if(doc["location"].is<String>() && doc["location"] != "")
       {
-        Serial.println("Location Tag found!");
-        String location = doc["location"].as<String>();
-        if(lastSpoolId != ""){
-          updateSpoolLocation(lastSpoolId, location);
-        }
-        else
-        {
-          Serial.println("Location update tag scanned without scanning spool before!");
-          oledShowProgressBar(1, 1, "Failure", "Scan spool first");
-        }
+        locationScanned(doc["location"].as<const char*>());
       }
       // Brand Filament not registered to Spoolman
       else if ((!doc["sm_id"].is<String>() || (doc["sm_id"].is<String>() && (doc["sm_id"] == "0" || doc["sm_id"] == "")))
               && doc["b"].is<String>() && doc["an"].is<String>())
       {
-        doc["sm_id"] = "0"; // Ensure sm_id is set to 0
         // If no sm_id is present but the brand is Brand Filament then
-        // create a new spool, maybe brand too, in Spoolman
+        // create a new spool, maybe brand too, in Spoolman. The requests run in a worker task.
         Serial.println("New Brand Filament Tag found!");
-        createBrandFilament(doc, uidString);
+        queueBrandFilament(nfcJsonData, uidString);
       }
       else 
       {
         Serial.println("Keine SPOOL-ID gefunden.");
-        activeSpoolId = "";
+        setActiveSpool(0);
         oledShowProgressBar(1, 1, "Failure", "Unkown tag");
       }
     }else{
@@ -1299,330 +1436,150 @@ bool decodeNdefAndReturnJson(const byte* encodedMessage, String uidString) {
   return true;
 }
 
-// Read complete JSON data for fast-path to enable web interface display
-bool readCompleteJsonForFastPath() {
-    Serial.println("=== FAST-PATH: Reading complete JSON for web interface ===");
-    
-    // Read tag size first
-    uint16_t tagSize = readTagSize();
-    if (tagSize == 0) {
-        Serial.println("FAST-PATH: Could not determine tag size");
-        return false;
-    }
-    
-    // Create buffer for complete data
-    uint8_t* data = (uint8_t*)malloc(tagSize);
-    if (!data) {
-        Serial.println("FAST-PATH: Could not allocate memory for complete read");
-        return false;
-    }
-    memset(data, 0, tagSize);
-    
-    // Read all pages
-    uint8_t numPages = tagSize / 4;
-    for (uint8_t i = 4; i < 4 + numPages; i++) {
-        if (!robustPageRead(i, data + (i - 4) * 4)) {
-            Serial.printf("FAST-PATH: Failed to read page %d\n", i);
-            free(data);
-            return false;
-        }
-        
-        // Check for NDEF message end
-        if (data[(i - 4) * 4] == 0xFE) {
-            Serial.println("FAST-PATH: Found NDEF message end marker");
-            break;
-        }
-        
-        yield();
-        esp_task_wdt_reset();
-        vTaskDelay(pdMS_TO_TICKS(2));
-    }
-    
-    // Decode NDEF and extract JSON
-    bool success = decodeNdefAndReturnJson(data, ""); // Empty UID string for fast-path
-    
-    free(data);
-    
-    if (success) {
-        Serial.println("✓ FAST-PATH: Complete JSON data successfully loaded");
-        Serial.print("nfcJsonData length: ");
-        Serial.println(nfcJsonData.length());
-    } else {
-        Serial.println("✗ FAST-PATH: Failed to decode complete JSON data");
-    }
-    
-    return success;
+// Appends "key":"value" to the JSON object in nfcJsonData, reading the record only as far as
+// needed. The value is copied as stored on the tag, escapes included, so it needs no decoding.
+bool appendJsonValue(NdefSource* source, NdefRecordView* record, const char* key, size_t* jsonLength) {
+    const char* value;
+    size_t valueLength;
+    if (!ndefSourceFindJsonValue(source, record, key, &value, &valueLength) || valueLength == 0) return false;
+
+    // Room for the separator, the key with its quotes and colon, the quotes of the value and the closing brace
+    size_t needed = 1 + strlen(key) + 3 + valueLength + 2 + 1;
+    if (*jsonLength + needed >= sizeof(nfcJsonData)) return false;
+
+    *jsonLength += sprintf(&nfcJsonData[*jsonLength], "%s\"%s\":\"", *jsonLength > 1 ? "," : "", key);
+    memcpy(&nfcJsonData[*jsonLength], value, valueLength);
+    *jsonLength += valueLength;
+    nfcJsonData[(*jsonLength)++] = '"';
+    nfcJsonData[*jsonLength] = '\0';
+    return true;
 }
 
-bool quickSpoolIdCheck(String uidString) {
-    // Fast-path: Read NDEF structure to quickly locate and check JSON payload
-    // This dramatically speeds up known spool recognition
-    
-    // CRITICAL: Do not execute during write operations!
-    if (nfcWriteInProgress) {
-        Serial.println("FAST-PATH: Skipped during write operation");
+// Reads the tag on demand: the NDEF parser pulls pages while it looks for the fields the
+// tag kind needs and stops there. Known spools only need the fields shown by the web
+// interface, location tags only the location. Brand filament and CBOR records are decoded whole.
+// checksum is set to the payload checksum in front of the message, 0 if the tag has none.
+// Spool and location tags are handled without heap allocations, the pages go to nfcCurrentPages.
+bool readTagOnDemand(const char* uidString, uint32_t* checksum) {
+    uint8_t* data = nfcCurrentPages;
+    NdefSource source = { data, 0, ntagUserDataSize(currentTag), fetchNdefPages, data };
+    NdefRecordView record;
+    nfcRoundTrips = 0;
+
+    bool isJson = ndefSourceFindRecord(&source, NULL, &record);
+    if (!ndefFindChecksum(data, source.available, checksum)) *checksum = 0;
+    if (!isJson && !ndefSourceFindRecord(&source, NDEF_MIME_CBOR, &record)) {
+        Serial.println("No NDEF JSON or CBOR record found in tag data");
         return false;
     }
-    
-    Serial.println("=== FAST-PATH: Quick sm_id Check ===");
-    
-    // Read enough pages to cover NDEF header + beginning of payload (pages 4-8 = 20 bytes)
-    uint8_t ndefData[20];
-    memset(ndefData, 0, 20);
-    
-    for (uint8_t page = 4; page < 9; page++) {
-        if (!robustPageRead(page, ndefData + (page - 4) * 4)) {
-            Serial.print("FAST-PATH: Failed to read page ");
-            Serial.print(page);
-            Serial.println(" - falling back to full read");
-            return false; // Fall back to full read if any page read fails
-        }
-    }
-    
-    // Parse NDEF structure to find JSON payload start
-    Serial.print("Raw NDEF data (first 20 bytes): ");
-    for (int i = 0; i < 20; i++) {
-        if (ndefData[i] < 0x10) Serial.print("0");
-        Serial.print(ndefData[i], HEX);
-        Serial.print(" ");
-    }
-    Serial.println();
-    
-    // Look for NDEF TLV (0x03) at the beginning
-    int tlvOffset = -1;
-    for (int i = 0; i < 8; i++) {
-        if (ndefData[i] == 0x03) {
-            tlvOffset = i;
-            Serial.print("Found NDEF TLV at offset: ");
-            Serial.println(tlvOffset);
-            break;
-        }
-    }
-    
-    if (tlvOffset == -1) {
-        Serial.println("✗ FAST-PATH: No NDEF TLV found");
-        return false;
+
+    bool success = true;
+    const char* value;
+    size_t valueLength;
+    size_t jsonLength = 1;
+    strcpy(nfcJsonData, "{");
+
+    uint32_t spoolId = 0;
+    if (isJson && ndefSourceFindJsonValue(&source, &record, "sm_id", &value, &valueLength)) {
+        spoolId = jsonValueToUint(value, valueLength);
     }
-    
-    // Parse NDEF record to find JSON payload
-    int ndefRecordStart;
-    if (ndefData[tlvOffset + 1] == 0xFF) {
-        // Extended length format
-        ndefRecordStart = tlvOffset + 4;
+
+    if (spoolId != 0) {
+        // sm_id is written first, so this usually ends with the first burst
+        appendJsonValue(&source, &record, "sm_id", &jsonLength);
+        appendJsonValue(&source, &record, "brand", &jsonLength);
+        appendJsonValue(&source, &record, "type", &jsonLength);
+        appendJsonValue(&source, &record, "color_hex", &jsonLength);
+        strcpy(&nfcJsonData[jsonLength], "}");
+
+        Serial.printf("✓ Known spool: %lu\n", (unsigned long)spoolId);
+        oledShowProgressBar(2, octoEnabled?5:4, "Known Spool", "Quick mode");
+        spoolScanned(spoolId);
+    } else if (isJson && ndefSourceFindJsonValue(&source, &record, "location", &value, &valueLength) && valueLength > 0) {
+        char location[SPOOLMAN_LOCATION_MAX_LENGTH];
+        jsonCopyValue(location, sizeof(location), value, valueLength);
+        appendJsonValue(&source, &record, "location", &jsonLength);
+        strcpy(&nfcJsonData[jsonLength], "}");
+        locationScanned(location);
     } else {
-        // Standard length format
-        ndefRecordStart = tlvOffset + 2;
-    }
-    
-    if (ndefRecordStart >= 20) {
-        Serial.println("✗ FAST-PATH: NDEF record starts beyond read data");
-        return false;
-    }
-    
-    // Parse NDEF record header
-    uint8_t recordHeader = ndefData[ndefRecordStart];
-    uint8_t typeLength = ndefData[ndefRecordStart + 1];
-    
-    // Calculate payload offset
-    uint8_t payloadLengthBytes = (recordHeader & 0x10) ? 1 : 4; // SR flag check
-    uint8_t idLength = (recordHeader & 0x08) ? ndefData[ndefRecordStart + 2 + payloadLengthBytes + typeLength] : 0; // IL flag check
-    
-    int payloadOffset = ndefRecordStart + 1 + 1 + payloadLengthBytes + typeLength + idLength;
-    
-    Serial.print("NDEF Record Header: 0x");
-    Serial.print(recordHeader, HEX);
-    Serial.print(", Type Length: ");
-    Serial.print(typeLength);
-    Serial.print(", Payload offset: ");
-    Serial.println(payloadOffset);
-    
-    // Check if payload starts within our read data
-    if (payloadOffset >= 20) {
-        Serial.println("✗ FAST-PATH: JSON payload starts beyond quick read data - need more pages");
-        
-        // Read additional pages to get to JSON payload
-        uint8_t extraData[16]; // Read 4 more pages
-        memset(extraData, 0, 16);
-        
-        for (uint8_t page = 9; page < 13; page++) {
-            if (!robustPageRead(page, extraData + (page - 9) * 4)) {
-                Serial.print("FAST-PATH: Failed to read additional page ");
-                Serial.print(page);
-                Serial.println(" - falling back to full read");
-                return false; // Fall back to full read if extended read fails
-            }
-        }
-        
-        // Combine data
-        uint8_t combinedData[36];
-        memcpy(combinedData, ndefData, 20);
-        memcpy(combinedData + 20, extraData, 16);
-        
-        // Extract JSON from combined data
-        String jsonStart = "";
-        int jsonStartPos = payloadOffset;
-        for (int i = 0; i < 36 - payloadOffset && i < 30; i++) {
-            uint8_t currentByte = combinedData[payloadOffset + i];
-            if (currentByte >= 32 && currentByte <= 126) {
-                jsonStart += (char)currentByte;
-            }
-            // Stop at first brace to get just the beginning
-            if (currentByte == '{' && i > 0) break;
-        }
-        
-        Serial.print("JSON start from extended read: ");
-        Serial.println(jsonStart);
-        
-        // Check for sm_id pattern - look for non-zero sm_id values
-        if (jsonStart.indexOf("\"sm_id\":\"") >= 0) {
-            int smIdStart = jsonStart.indexOf("\"sm_id\":\"") + 9;
-            int smIdEnd = jsonStart.indexOf("\"", smIdStart);
-            
-            if (smIdEnd > smIdStart && smIdEnd < jsonStart.length()) {
-                String quickSpoolId = jsonStart.substring(smIdStart, smIdEnd);
-                Serial.print("Found sm_id in extended read: ");
-                Serial.println(quickSpoolId);
-                
-                // Only process if sm_id is not "0" (known spool)
-                if (quickSpoolId != "0" && quickSpoolId.length() > 0) {
-                    Serial.println("✓ FAST-PATH: Known spool detected!");
-                    
-                    // Set as active spool immediately
-                    activeSpoolId = quickSpoolId;
-                    lastSpoolId = activeSpoolId;
-                    
-                    // Read complete JSON data for web interface display
-                    Serial.println("FAST-PATH: Reading complete JSON data for web interface...");
-                    if (readCompleteJsonForFastPath()) {
-                        Serial.println("✓ FAST-PATH: Complete JSON data loaded for web interface");
-                    } else {
-                        Serial.println("⚠ FAST-PATH: Could not read complete JSON, web interface may show limited data");
-                    }
-                    
-                    oledShowProgressBar(2, octoEnabled?5:4, "Known Spool", "Quick mode");
-                    Serial.println("✓ FAST-PATH SUCCESS: Known spool processed quickly");
-                    return true;
-                } else {
-                    Serial.println("✗ FAST-PATH: sm_id is 0 - new brand filament, need full read");
-                    return false;
-                }
-            }
-        }
-        
-        Serial.println("✗ FAST-PATH: No sm_id pattern in extended read");
-        return false;
-    }
-    
-    // Extract JSON payload from the available data
-    String quickJson = "";
-    for (int i = payloadOffset; i < 20 && i < payloadOffset + 15; i++) {
-        uint8_t currentByte = ndefData[i];
-        if (currentByte >= 32 && currentByte <= 126) {
-            quickJson += (char)currentByte;
-        }
-    }
-    
-    Serial.print("Quick JSON data: ");
-    Serial.println(quickJson);
-    
-    // Look for sm_id pattern in the beginning of JSON - check for known vs new spools
-    if (quickJson.indexOf("\"sm_id\":\"") >= 0) {
-        Serial.println("✓ FAST-PATH: sm_id field found");
-        
-        // Extract sm_id from quick data
-        int smIdStart = quickJson.indexOf("\"sm_id\":\"") + 9;
-        int smIdEnd = quickJson.indexOf("\"", smIdStart);
-        
-        if (smIdEnd > smIdStart && smIdEnd < quickJson.length()) {
-            String quickSpoolId = quickJson.substring(smIdStart, smIdEnd);
-            Serial.print("✓ Quick extracted sm_id: ");
-            Serial.println(quickSpoolId);
-            
-            // Only process known spools (sm_id != "0") via fast path
-            if (quickSpoolId != "0" && quickSpoolId.length() > 0) {
-                Serial.println("✓ FAST-PATH: Known spool detected!");
-                
-                // Set as active spool immediately
-                activeSpoolId = quickSpoolId;
-                lastSpoolId = activeSpoolId;
-                
-                // Read complete JSON data for web interface display
-                Serial.println("FAST-PATH: Reading complete JSON data for web interface...");
-                if (readCompleteJsonForFastPath()) {
-                    Serial.println("✓ FAST-PATH: Complete JSON data loaded for web interface");
-                } else {
-                    Serial.println("⚠ FAST-PATH: Could not read complete JSON, web interface may show limited data");
-                }
-                
-                oledShowProgressBar(2, octoEnabled?5:4, "Known Spool", "Quick mode");
-                Serial.println("✓ FAST-PATH SUCCESS: Known spool processed quickly");
-                return true;
-            } else {
-                Serial.println("✗ FAST-PATH: sm_id is 0 - new brand filament, need full read");
-                return false; // sm_id="0" means new brand filament, needs full processing
-            }
-        } else {
-            Serial.println("✗ FAST-PATH: Could not extract complete sm_id value");
-            return false; // Need full read to get complete sm_id
+        // Brand filament tags and CBOR records need the complete payload
+        success = ndefSourceLoadPayload(&source, &record);
+        if (success) {
+          unsigned long decodeStart = micros();
+          success = decodeNdefAndReturnJson(data, source.available, uidString);
+          nfcLatencyRecord(NFC_PHASE_DECODE, micros() - decodeStart);
         }
     }
-    
-    // Check for other patterns that require full read
-    if (quickJson.indexOf("\"location\":\"") >= 0) {
-        Serial.println("✓ FAST-PATH: Location tag detected");
-        return false; // Need full read for location processing
-    }
-    
-    if (quickJson.indexOf("\"brand\":\"") >= 0) {
-        Serial.println("✓ FAST-PATH: Brand filament detected - may need full processing");
-        return false; // Need full read for brand filament creation
-    }
-    
-    Serial.println("✗ FAST-PATH: No recognizable pattern - falling back to full read");
-    return false; // Fall back to full tag reading
+
+    Serial.printf("Tag read: %d bytes, %d PN532 round trips\n", (int)source.available, nfcRoundTrips);
+    return success;
+}
+
+// Reads only the checksum TLV in front of the message, one burst of two pages
+bool readTagChecksum(uint32_t* checksum) {
+    uint8_t pages[NDEF_CHECKSUM_TLV_SIZE];
+    return ntag2xx_ReadPages(4, NDEF_CHECKSUM_TLV_SIZE / 4, pages) && ndefFindChecksum(pages, sizeof(pages), checksum);
+}
+
+// Writes the record of the command to the selected tag and keeps the tag cache in step
+bool writeCommandToTag(const NfcCommand& command, const uint8_t* uid, uint8_t uidLength) {
+  // The tag content changes, a failed write must not leave a stale cache entry behind
+  tagCacheInvalidate(uid, uidLength);
+
+  // Schreibe die NDEF-Message auf den Tag
+  unsigned long start = micros();
+  // currentTag also picks the read command of the diff and the verify read
+  bool success = detectTagCapability(uid, uidLength, &currentTag) &&
+                 ntag2xx_WriteNDEF(command.format, command.record, command.recordLength, &currentTag, uid, uidLength);
+  nfcLatencyRecord(NFC_PHASE_WRITE_TOTAL, micros() - start);
+  if (success) {
+    tagCacheStore(uid, uidLength, command.slot->payload, strlen(command.slot->payload),
+                  tagCacheCrc32(command.record, command.recordLength));
+  }
+  return success;
 }
 
-void writeJsonToTag(void *parameter) {
-  NfcWriteParameterType* params = (NfcWriteParameterType*)parameter;
+// Waits for the tag of an interrupted write to come back while its progress is still valid
+bool waitForResumableTag(const uint8_t* uid, uint8_t uidLength) {
+  uint8_t presentUid[7];
+  uint8_t presentUidLength;
+  while (isWriteProgressFor(uid, uidLength)) {
+    yield();
+    esp_task_wdt_reset();
+    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, presentUid, &presentUidLength, 400) &&
+        presentUidLength == uidLength && memcmp(presentUid, uid, uidLength) == 0) {
+      return true;
+    }
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  return false;
+}
 
+// Runs in the NFC task, scanning is paused until the write is done
+void writeJsonToTag(const NfcCommand& command) {
   // Gib die erstellte NDEF-Message aus
   Serial.println("Erstelle NDEF-Message...");
-  Serial.println(params->payload);
+  Serial.println(command.slot->payload);
 
   nfcReaderState = NFC_WRITING;
-  nfcWriteInProgress = true; // Block high-level tag operations during write
-
-  // Do NOT suspend the reading task - we need NFC interface for verification
-  // Just use nfcWriteInProgress to prevent scanning and fast-path operations
-  Serial.println("NFC Write Task starting - High-level operations blocked, low-level NFC available");
-
-  //pauseBambuMqttTask = true;
-  // aktualisieren der Website wenn sich der Status ändert
-  sendNfcData();
-  vTaskDelay(100 / portTICK_PERIOD_MS);
+  emitNfcEvent(NFC_EVENT_WRITE_STARTED, true, "", command.slot->payload, command.isSpoolTag);
   
   // Show waiting message for tag detection
   oledShowProgressBar(0, 1, "Write Tag", "Warte auf Tag");
   
   // Wait 10sec for tag
   uint8_t success = 0;
-  String uidString = "";
+  char uidString[NFC_UID_STRING_SIZE] = "";
+  uint8_t writeUid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
+  uint8_t writeUidLength = 0;
   for (uint16_t i = 0; i < 20; i++) {
-    uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
-    uint8_t uidLength;
     // yield before potentially waiting for 400ms
     yield();
     esp_task_wdt_reset();
-    success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 400);
+    success = nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, writeUid, &writeUidLength, 400);
     if (success) {
-      for (uint8_t i = 0; i < uidLength; i++) {
-        //TBD: Rework to remove all the string operations
-        uidString += String(uid[i], HEX);
-        if (i < uidLength - 1) {
-            uidString += ":"; // Optional: Trennzeichen hinzufügen
-        }
-      }
-      foundNfcTag(nullptr, success);
+      formatUid(writeUid, writeUidLength, uidString);
+      emitNfcEvent(NFC_EVENT_TAG_ARRIVED, true, uidString);
       break;
     }
 
@@ -1635,127 +1592,34 @@ void writeJsonToTag(void *parameter) {
   {
     oledShowProgressBar(1, 3, "Write Tag", "Writing");
 
-    // Schreibe die NDEF-Message auf den Tag
-    success = ntag2xx_WriteNDEF(params->payload);
+    success = writeCommandToTag(command, writeUid, writeUidLength);
+
+    // Tag lifted mid-write: put back in time, it continues from the first page not yet written
+    while (!success && nfcWriteProgress.tagLost && isWriteProgressFor(writeUid, writeUidLength)) {
+      Serial.println("Tag wieder auflegen, um den Schreibvorgang fortzusetzen...");
+      oledShowProgressBar(1, 3, "Write Tag", "Place tag again");
+      if (!waitForResumableTag(writeUid, writeUidLength)) break;
+
+      oledShowProgressBar(1, 3, "Write Tag", "Resuming");
+      success = writeCommandToTag(command, writeUid, writeUidLength);
+    }
+
     if (success) 
     {
         Serial.println("NDEF-Message erfolgreich auf den Tag geschrieben");
         //oledShowMessage("NFC-Tag written");
         //vTaskDelay(1000 / portTICK_PERIOD_MS);
         nfcReaderState = NFC_WRITE_SUCCESS;
-        // aktualisieren der Website wenn sich der Status ändert
-        sendNfcData();
-        pauseBambuMqttTask = false;
-        
-        if(params->tagType){
-          // TBD: should this be simplified?
-          if (updateSpoolTagId(uidString, params->payload) && params->tagType) {
-            // Check if weight is over 20g and send to Spoolman
-            if (weight > 20) {
-              Serial.println("Tag successfully written and weight > 20g - sending weight to Spoolman");
-              
-              // Extract spool ID from payload for weight update
-              JsonDocument payloadDoc;
-              DeserializationError error = deserializeJson(payloadDoc, params->payload);
-              
-              if (!error && payloadDoc["sm_id"].is<String>()) {
-                String spoolId = payloadDoc["sm_id"].as<String>();
-                if (spoolId != "") {
-                  Serial.printf("Updating spool %s with weight %dg\n", spoolId.c_str(), weight);
-                  updateSpoolWeight(spoolId, weight);
-                } else {
-                  Serial.println("No valid spool ID found for weight update");
-                }
-              } else {
-                Serial.println("Error parsing payload for spool ID extraction");
-              }
-              
-              payloadDoc.clear();
-            } else {
-              Serial.printf("Weight %dg is not above 20g threshold - skipping weight update\n", weight);
-            }
-          }else{
-            // Potentially handle errors
-          }
-        }else{
+        rememberPresentTag(writeUid, writeUidLength);
+        // Spoolman is updated by the API subscriber
+        emitNfcEvent(NFC_EVENT_WRITE_DONE, true, uidString, command.slot->payload, command.isSpoolTag);
+
+        if(!command.isSpoolTag){
           oledShowProgressBar(1, 1, "Write Tag", "Done!");
         }
-        
-        // CRITICAL: Properly stabilize NFC interface after write operation
-        Serial.println();
-        Serial.println("=== POST-WRITE NFC STABILIZATION ===");
-        
-        // Wait for tag operations to complete
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        
-        // Test tag presence and remove detection
-        uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-        uint8_t uidLength;
-        int tagRemovalChecks = 0;
-        
-        Serial.println("Warte bis Tag entfernt wird...");
-        
-        // Monitor tag presence
-        while (tagRemovalChecks < 10) {
-          yield();
-          esp_task_wdt_reset();
-          
-          bool tagPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 500);
-          
-          if (!tagPresent) {
-            Serial.println("✓ Tag wurde entfernt - NFC bereit für nächsten Scan");
-            break;
-          }
-          
-          tagRemovalChecks++;
-          Serial.print("Tag noch vorhanden (");
-          Serial.print(tagRemovalChecks);
-          Serial.println("/10)");
-          
-          vTaskDelay(500 / portTICK_PERIOD_MS);
-        }
-        
-        if (tagRemovalChecks >= 10) {
-          Serial.println("WARNUNG: Tag wurde nicht entfernt - fahre trotzdem fort");
-        }
-        
-        // Additional interface stabilization before resuming normal operations
-        Serial.println("Stabilisiere NFC-Interface für normale Operationen...");
-        vTaskDelay(200 / portTICK_PERIOD_MS);
-        
-        // Test if interface is ready for normal scanning
-        uint8_t interfaceTestBuffer[4];
-        bool interfaceReady = false;
-        
-        for (int testAttempt = 0; testAttempt < 3; testAttempt++) {
-          // Try a simple interface operation (without requiring tag presence)
-          Serial.print("Interface readiness test ");
-          Serial.print(testAttempt + 1);
-          Serial.print("/3... ");
-          
-          // Use a safe read operation that doesn't depend on tag presence
-          // This tests if the PN532 chip itself is responsive
-          uint32_t versiondata = nfc.getFirmwareVersion();
-          if (versiondata != 0) {
-            Serial.println("✓");
-            interfaceReady = true;
-            break;
-          } else {
-            Serial.println("❌");
-            vTaskDelay(100 / portTICK_PERIOD_MS);
-          }
-        }
-        
-        if (!interfaceReady) {
-          Serial.println("WARNUNG: NFC-Interface reagiert nicht - könnte normale Scans beeinträchtigen");
-        } else {
-          Serial.println("✓ NFC-Interface ist bereit für normale Scans");
-        }
-        
-        Serial.println("=========================================");
-        
-        vTaskResume(RfidReaderTask);
-        vTaskDelay(500 / portTICK_PERIOD_MS);        
+
+        // No wait for the removal here: the scan loop checks the presence of the remembered
+        // tag and reports NFC_EVENT_TAG_REMOVED, the next command is handled right away
     } 
     else 
     {
@@ -1763,6 +1627,7 @@ void writeJsonToTag(void *parameter) {
         oledShowIcon("failed");
         vTaskDelay(2000 / portTICK_PERIOD_MS);
         nfcReaderState = NFC_WRITE_ERROR;
+        rememberPresentTag(writeUid, writeUidLength);
     }
   }
   else
@@ -1773,28 +1638,27 @@ void writeJsonToTag(void *parameter) {
     nfcReaderState = NFC_IDLE;
   }
   
-  sendWriteResult(nullptr, success);
-  sendNfcData();
-
-  // Only reset the write protection flag - reading task was never suspended
-  nfcWriteInProgress = false; // Re-enable high-level tag operations
-  pauseBambuMqttTask = false;
-
-  free(params->payload);
-  delete params;
+  if (!success) {
+    emitNfcEvent(NFC_EVENT_WRITE_DONE, false, uidString, command.slot->payload, command.isSpoolTag);
+  }
 
-  vTaskDelete(NULL);
+  releaseWriteSlot(command.slot);
 }
 
-// Ensures sm_id is always the first key in JSON for fast-path detection
-String optimizeJsonForFastPath(const char* payload) {
+// Ensures sm_id is always the first key in JSON for fast-path detection.
+// Writes the result to buffer, returns its length or 0 if it does not fit.
+size_t optimizeJsonForFastPath(const char* payload, char* buffer, size_t bufferSize) {
     JsonDocument inputDoc;
     DeserializationError error = deserializeJson(inputDoc, payload);
     
     if (error) {
         Serial.print("JSON optimization failed: ");
         Serial.println(error.c_str());
-        return String(payload); // Return original if parsing fails
+        // Use the original if parsing fails
+        size_t length = strlen(payload);
+        if (length >= bufferSize) return 0;
+        memcpy(buffer, payload, length + 1);
+        return length;
     }
     
     // Create optimized JSON with sm_id first
@@ -1818,71 +1682,187 @@ String optimizeJsonForFastPath(const char* payload) {
         }
     }
     
-    String optimizedJson;
-    serializeJson(optimizedDoc, optimizedJson);
+    size_t length = measureJson(optimizedDoc);
+    if (length >= bufferSize) return 0;
+    serializeJson(optimizedDoc, buffer, bufferSize);
     
     Serial.println("JSON optimized for fast-path detection:");
     Serial.print("Original:  ");
     Serial.println(payload);
     Serial.print("Optimized: ");
-    Serial.println(optimizedJson);
+    Serial.println(buffer);
     
     inputDoc.clear();
     optimizedDoc.clear();
     
-    return optimizedJson;
+    return length;
+}
+
+// Points the command at the record for the JSON in its slot, CBOR encoded if requested
+void prepareWriteRecord(NfcCommand& command, size_t payloadLength, nfcPayloadFormatType format) {
+  NfcWriteSlot* slot = command.slot;
+  command.record = (const uint8_t*)slot->payload;
+  command.recordLength = payloadLength;
+  command.format = NFC_FORMAT_JSON;
+
+  if (format == NFC_FORMAT_CBOR) {
+    JsonDocument doc;
+    size_t cborLength = 0;
+    if (!deserializeJson(doc, slot->payload, payloadLength)) {
+      cborLength = spoolCborEncode(doc.as<JsonObjectConst>(), slot->record, sizeof(slot->record));
+    }
+
+    if (cborLength > 0) {
+      Serial.printf("CBOR payload: %u bytes (JSON: %u bytes)\n", (unsigned int)cborLength, (unsigned int)payloadLength);
+      command.record = slot->record;
+      command.recordLength = cborLength;
+      command.format = NFC_FORMAT_CBOR;
+    } else {
+      Serial.println("Payload cannot be encoded as CBOR - writing JSON");
+    }
+  }
 }
 
-void startWriteJsonToTag(const bool isSpoolTag, const char* payload) {
+void startWriteJsonToTag(const bool isSpoolTag, const char* payload, nfcPayloadFormatType format) {
+  // All slots in use means the queue is full of writes already
+  NfcWriteSlot* slot;
+  if (nfcFreeSlotQueue == NULL || xQueueReceive(nfcFreeSlotQueue, &slot, 0) != pdTRUE) {
+    oledShowProgressBar(0, 1, "FAILURE", "NFC busy!");
+    // TBD: Add proper error handling (website)
+    return;
+  }
+
   // Optimize JSON to ensure sm_id is first key for fast-path detection
-  String optimizedPayload = optimizeJsonForFastPath(payload);
+  size_t payloadLength = optimizeJsonForFastPath(payload, slot->payload, sizeof(slot->payload));
+  if (payloadLength == 0) {
+    Serial.println("Payload zu groß für alle unterstützten Tags");
+    oledShowProgressBar(0, 1, "FAILURE", "Payload too large");
+    releaseWriteSlot(slot);
+    return;
+  }
   
-  NfcWriteParameterType* parameters = new NfcWriteParameterType();
-  parameters->tagType = isSpoolTag;
-  parameters->payload = strdup(optimizedPayload.c_str()); // Use optimized payload
+  NfcCommand command = {};
+  command.type = NFC_CMD_WRITE;
+  command.isSpoolTag = isSpoolTag;
+  command.slot = slot;
+  prepareWriteRecord(command, payloadLength, format);
   
-  // Task nicht mehrfach starten
-  if (nfcReaderState == NFC_IDLE || nfcReaderState == NFC_READ_ERROR || nfcReaderState == NFC_READ_SUCCESS) {
+  // The NFC task runs the write as soon as the current scan is done
+  if (queueNfcCommand(command)) {
     oledShowProgressBar(0, 1, "Write Tag", "Place tag now");
-    // Erstelle die Task
-    xTaskCreate(
-        writeJsonToTag,        // Task-Funktion
-        "WriteJsonToTagTask",       // Task-Name
-        5115,                        // Stackgröße in Bytes
-        (void*)parameters,         // Parameter
-        rfidWriteTaskPrio,           // Priorität
-        NULL                         // Task-Handle (nicht benötigt)
-    );
   }else{
     oledShowProgressBar(0, 1, "FAILURE", "NFC busy!");
     // TBD: Add proper error handling (website)
+    releaseWriteSlot(slot);
+  }
+}
+
+bool startBatchWrite(const bool isSpoolTag, JsonArrayConst payloads, nfcPayloadFormatType format) {
+  size_t count = payloads.size();
+  if (count == 0 || count > NFC_BATCH_MAX_TAGS) {
+    Serial.printf("Batch mit %u Payloads nicht möglich (max. %u)\n", (unsigned int)count, (unsigned int)NFC_BATCH_MAX_TAGS);
+    return false;
+  }
+
+  // The batch keeps one write slot for its encoding buffers until it ends
+  NfcWriteSlot* slot;
+  if (nfcFreeSlotQueue == NULL || xQueueReceive(nfcFreeSlotQueue, &slot, 0) != pdTRUE) {
+    oledShowProgressBar(0, 1, "FAILURE", "NFC busy!");
+    return false;
+  }
+
+  // Optimizing keeps the length of the compact JSON, only a missing sm_id is added
+  size_t bufferSize = 0;
+  for (JsonVariantConst payload : payloads) {
+    bufferSize += measureJson(payload) + sizeof("\"sm_id\":\"0\",");
+  }
+
+  // A running batch still belongs to the NFC task until the new one replaces it, so each batch gets its own memory
+  NfcBatch* batch = new (std::nothrow) NfcBatch();
+  char* buffer = new (std::nothrow) char[bufferSize];
+  if (batch == nullptr || buffer == nullptr) {
+    Serial.println("Fehler: Kann Speicher für den Batch nicht allokieren.");
+    delete batch;
+    delete[] buffer;
+    releaseWriteSlot(slot);
+    return false;
+  }
+
+  // Payloads are checked here, the NFC task only copies them into the slot
+  size_t used = 0;
+  for (JsonVariantConst payload : payloads) {
+    size_t payloadLength = 0;
+    if (payload.is<JsonObjectConst>() && measureJson(payload) < sizeof(slot->payload)) {
+      serializeJson(payload, slot->payload, sizeof(slot->payload));
+      payloadLength = optimizeJsonForFastPath(slot->payload, buffer + used, min(bufferSize - used, sizeof(slot->payload)));
+    }
+
+    if (payloadLength == 0) {
+      Serial.printf("Batch-Payload %u ungültig oder zu groß\n", (unsigned int)batch->count + 1);
+      oledShowProgressBar(0, 1, "FAILURE", "Payload too large");
+      delete batch;
+      delete[] buffer;
+      releaseWriteSlot(slot);
+      return false;
+    }
+
+    used += payloadLength + 1;
+    batch->count++;
+  }
+
+  batch->isSpoolTag = isSpoolTag;
+  batch->format = format;
+  batch->payloads = buffer;
+  batch->nextPayload = buffer;
+  batch->slot = slot;
+
+  NfcCommand command = {};
+  command.type = NFC_CMD_BATCH_START;
+  command.isSpoolTag = isSpoolTag;
+  command.batch = batch;
+
+  if (!queueNfcCommand(command)) {
+    oledShowProgressBar(0, 1, "FAILURE", "NFC busy!");
+    delete batch;
+    delete[] buffer;
+    releaseWriteSlot(slot);
+    return false;
   }
+  return true;
+}
+
+bool stopBatchWrite() {
+  return nfcSendCommand(NFC_CMD_BATCH_STOP);
 }
 
 // Safe tag detection with manual retry logic and short timeouts
 bool safeTagDetection(uint8_t* uid, uint8_t* uidLength) {
-    const int MAX_ATTEMPTS = 3;
     const int SHORT_TIMEOUT = 100; // Very short timeout to prevent hanging
+    TagRetryPolicy policy = tagStatsDetectionPolicy();
     
-    for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+    for (int attempt = 0; attempt < policy.attempts; attempt++) {
         // Watchdog reset on each attempt
         esp_task_wdt_reset();
         yield();
         
         // Use short timeout to avoid blocking
-        bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, SHORT_TIMEOUT);
+        bool success = nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, SHORT_TIMEOUT);
         
         if (success) {
             Serial.printf("✓ Tag detected on attempt %d with %dms timeout\n", attempt + 1, SHORT_TIMEOUT);
+            tagStatsRecordDetection(uid, *uidLength, attempt);
             return true;
         }
         
+        // Detections that never needed a retry skip the pause and the RF field refresh
+        if (policy.retryDelayMs == 0) continue;
+
         // Short pause between attempts
-        vTaskDelay(pdMS_TO_TICKS(25));
+        vTaskDelay(pdMS_TO_TICKS(tagStatsRetryDelay(policy, attempt + 1)));
         
         // Refresh RF field after failed attempt (but not on last attempt)
-        if (attempt < MAX_ATTEMPTS - 1) {
-            nfc.SAMConfig();
+        if (attempt < policy.attempts - 1) {
+            nfc->SAMConfig();
             vTaskDelay(pdMS_TO_TICKS(10));
         }
     }
@@ -1890,196 +1870,515 @@ bool safeTagDetection(uint8_t* uid, uint8_t* uidLength) {
     return false;
 }
 
-void scanRfidTask(void * parameter) {
-  Serial.println("RFID Task gestartet");
-  for(;;) {
-    // Regular watchdog reset
-    esp_task_wdt_reset();
-    yield();
-    
-    // Skip scanning during write operations, but keep NFC interface active
-    if (nfcReaderState != NFC_WRITING && !nfcWriteInProgress && !nfcReadingTaskSuspendRequest && !booting)
-    {
-      nfcReadingTaskSuspendState = false;
-      yield();
+void IRAM_ATTR nfcIrqHandler() {
+    // The IRQ line also signals every command response, only card detection is of interest here
+    if (!nfcIrqArmed || RfidReaderTask == NULL) return;
+    nfcIrqArmed = false;
 
-      uint8_t success;
-      uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
-      uint8_t uidLength;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(RfidReaderTask, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) portYIELD_FROM_ISR();
+}
 
-      // Use safe tag detection instead of blocking readPassiveTargetID
-      success = safeTagDetection(uid, &uidLength);
+// Ends a pending InListPassiveTarget so other commands get a clean response
+void cancelIrqTagDetection() {
+    if (!nfcIrqListening) return;
+    nfcIrqArmed = false;
+    nfcIrqListening = false;
+    nfc->getFirmwareVersion();
+}
 
-      foundNfcTag(nullptr, success);
-      
-      // Reset activeSpoolId immediately when no tag is detected to prevent stale autoSet
-      if (!success) {
-        activeSpoolId = "";
-      }
-      
-      // As long as there is still a tag on the reader, do not try to read it again
-      if (success && nfcReaderState == NFC_IDLE)
-      {
-        // Set the current tag as not processed
-        tagProcessed = false;
+// Interrupt driven detection: the PN532 polls for a card itself and pulls IRQ low on arrival,
+// the reader task sleeps until then instead of sending a command every round.
+bool irqTagDetection(uint8_t* uid, uint8_t* uidLength) {
+    if (!nfcIrqListening) {
+        ulTaskNotifyTake(pdTRUE, 0); // Drop notifications of earlier command responses
+        if (!nfc->startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A)) {
+            Serial.println("IRQ detection could not be started - polling this round");
+            return safeTagDetection(uid, uidLength);
+        }
+        nfcIrqListening = true;
+        nfcIrqArmed = true;
 
-        // Display some basic information about the card
-        Serial.println("Found an ISO14443A card");
+        // A card that was already in the field may have answered before the ISR was armed
+        if (digitalRead(PN532_IRQ) == LOW) {
+            nfcIrqArmed = false;
+            xTaskNotifyGive(RfidReaderTask);
+        }
+    }
 
-        nfcReaderState = NFC_READING;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NFC_IRQ_WAIT_TIMEOUT)) == 0) {
+        return false; // Still listening, nothing arrived
+    }
 
-        oledShowProgressBar(0, octoEnabled?5:4, "Reading", "Detecting tag");
+    // Woken up by a command, the PN532 is needed for something else
+    if (uxQueueMessagesWaiting(nfcCommandQueue) > 0) {
+        cancelIrqTagDetection();
+        return false;
+    }
 
-        // Reduced stabilization time for better responsiveness
-        Serial.println("Tag detected, minimal stabilization...");
-        vTaskDelay(200 / portTICK_PERIOD_MS); // Reduced from 1000ms to 200ms
+    nfcIrqListening = false;
+    nfcIrqArmed = false;
+    if (!nfc->readDetectedPassiveTargetID(uid, uidLength)) {
+        return false;
+    }
 
-        // create Tag UID string
-        String uidString = "";
-        for (uint8_t i = 0; i < uidLength; i++) {
-          //TBD: Rework to remove all the string operations
-          uidString += String(uid[i], HEX);
-          if (i < uidLength - 1) {
-              uidString += ":"; // Optional: Trennzeichen hinzufügen
-          }
-        }
-        
-        if (uidLength == 7)
-        {
-          // Try fast-path detection first for known spools
-          if (quickSpoolIdCheck(uidString)) {
-              Serial.println("✓ FAST-PATH: Tag processed quickly, skipping full read");
-              pauseBambuMqttTask = false;
-              // Set reader back to idle for next scan
-              nfcReaderState = NFC_READ_SUCCESS;
-              delay(500); // Small delay before next scan
-              continue; // Skip full tag reading and continue scan loop
-          }
+    Serial.println("✓ Tag detected via IRQ");
+    return true;
+}
 
-          Serial.println("Continuing with full tag read after fast-path check");
+// Several readers: every idle reader keeps an InListPassiveTarget pending and its IRQ line tells
+// when a card answered. A turn costs one pin read, no reader waits for the timeout of another one.
+bool muxTagDetection(uint8_t* uid, uint8_t* uidLength) {
+    if (!nfcIrqListening) {
+        if (!nfc->startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A)) return false;
+        nfcIrqListening = true;
+    }
 
-          uint16_t tagSize = readTagSize();
-          if(tagSize > 0)
-          {
-            // Create a buffer depending on the size of the tag
-            uint8_t* data = (uint8_t*)malloc(tagSize);
-            memset(data, 0, tagSize);
+    // A card that was already in the field answers right away
+    if (digitalRead(nfcReaders[nfcSelectedReader].config.irqPin) != LOW) return false;
 
-            // We probably have an NTAG2xx card (though it could be Ultralight as well)
-            Serial.println("Seems to be an NTAG2xx tag (7 byte UID)");
-            Serial.print("Tag size: ");
-            Serial.print(tagSize);
-            Serial.println(" bytes");
-            
-            uint8_t numPages = readTagSize()/4;
-            
-            for (uint8_t i = 4; i < 4+numPages; i++) {
-              
-              if (!robustPageRead(i, data+(i-4) * 4))
-              {
-                Serial.printf("Failed to read page %d after retries, stopping\n", i);
-                break; // Stop if reading fails after retries
-              }
-             
-              // Check for NDEF message end
-              if (data[(i - 4) * 4] == 0xFE) 
-              {
-                Serial.println("Found NDEF message end marker");
-                break; // End of NDEF message
-              }
-
-              yield();
-              esp_task_wdt_reset();
-              // Reduced delay for faster reading
-              vTaskDelay(pdMS_TO_TICKS(2)); // Reduced from 5ms to 2ms
-            }
-            
-            Serial.println("Tag reading completed, starting NDEF decode...");
-            
-            if (!decodeNdefAndReturnJson(data, uidString)) 
-            {
-              oledShowProgressBar(1, 1, "Failure", "Unknown tag");
-              nfcReaderState = NFC_READ_ERROR;
-            }
-            else 
-            {
-              nfcReaderState = NFC_READ_SUCCESS;
-            }
+    nfcIrqListening = false;
+    if (!nfc->readDetectedPassiveTargetID(uid, uidLength)) return false;
 
-            free(data);
-          }
-          else
-          {
-            oledShowProgressBar(1, 1, "Failure", "Tag read error");
-            nfcReaderState = NFC_READ_ERROR;
-            // Reset activeSpoolId when tag reading fails to prevent autoSet
-            activeSpoolId = "";
-            Serial.println("Tag read failed - activeSpoolId reset to prevent autoSet");
+    Serial.printf("✓ Tag detected on reader %u\n", (unsigned int)nfcSelectedReader);
+    tagStatsRecordDetection(uid, *uidLength, 0);
+    return true;
+}
+
+// RFConfiguration item 1: bit 0 switches the RF field, automatic RF collision avoidance stays off.
+// The command has no payload in its response, the ACK is enough like for setPassiveActivationRetries.
+bool setRfField(bool on) {
+    uint8_t command[] = { PN532_COMMAND_RFCONFIGURATION, 0x01, (uint8_t)(on ? 0x01 : 0x00) };
+    if (!nfc->sendCommandCheckAck(command, sizeof(command))) return false;
+    nfcRfFieldOff = !on;
+    return true;
+}
+
+void nfcWeightStep() {
+    nfcWeightStepPending = true;
+    if (nfcDutyCycleSleeping && RfidReaderTask != NULL) xTaskNotifyGive(RfidReaderTask);
+}
+
+// Duty cycling while the reader is idle and the scale is empty. A weight step, a command or a
+// tag keep the reader polling at full rate for NFC_ACTIVE_HOLD_TIME. Not with shelf readers,
+// their round-robin keeps going anyway.
+bool dutyCycleActive() {
+    if (nfcWeightStepPending) {
+        nfcWeightStepPending = false;
+        nfcLastActivity = millis();
+    }
+    return NFC_DUTY_CYCLE_ENABLED && nfcReaderCount == 1 && nfcReaderState == NFC_IDLE && nfcBatch == NULL &&
+           weight < NFC_LOAD_THRESHOLD && millis() - nfcLastActivity >= NFC_ACTIVE_HOLD_TIME;
+}
+
+// One duty cycle poll: the field is on for a single InListPassiveTarget and off until the next one
+bool dutyCycleTagDetection(uint8_t* uid, uint8_t* uidLength) {
+    cancelIrqTagDetection(); // A pending detection keeps the field on
+    if (nfcRfFieldOff) setRfField(true);
+
+    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, NFC_IDLE_POLL_TIMEOUT)) {
+        Serial.println("✓ Tag detected by duty cycle poll");
+        tagStatsRecordDetection(uid, *uidLength, 0);
+        return true;
+    }
+
+    setRfField(false);
+    return false;
+}
+
+// Pause until the next duty cycle poll, commands and weight steps end it early
+void waitForDutyCycle() {
+    nfcDutyCycleSleeping = true;
+    if (!nfcWeightStepPending && uxQueueMessagesWaiting(nfcCommandQueue) == 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NFC_IDLE_POLL_INTERVAL));
+    }
+    nfcDutyCycleSleeping = false;
+}
+
+// Ends the running batch and hands its buffers back
+void finishBatchWrite(bool completed) {
+  if (nfcBatch == NULL) return;
+
+  Serial.printf("Batch beendet: %u von %u Tags geschrieben\n", (unsigned int)nfcBatch->written, (unsigned int)nfcBatch->count);
+  oledShowProgressBar(1, 1, "Batch", completed ? "Done!" : "Cancelled");
+  emitNfcEvent(NFC_EVENT_BATCH_DONE, completed);
+
+  releaseWriteSlot(nfcBatch->slot);
+  delete[] nfcBatch->payloads;
+  delete nfcBatch;
+  nfcBatch = NULL;
+}
+
+// Writes the next batch payload to a newly presented tag. No waiting for the tag and
+// no removal loop: presence tracking notices the swap and the next tag is written at once.
+void writeNextBatchTag(const uint8_t* uid, uint8_t uidLength, const char* uidString) {
+  NfcBatch* batch = nfcBatch;
+
+  nfcReaderState = NFC_WRITING;
+  emitNfcEvent(NFC_EVENT_TAG_ARRIVED, true, uidString);
+
+  if (uidLength != 7) {
+    Serial.println("This doesn't seem to be an NTAG2xx tag (UUID length != 7 bytes)!");
+    oledShowProgressBar(batch->written, batch->count, "Batch", "Unkown tag type");
+    nfcReaderState = NFC_WRITE_ERROR;
+    emitNfcEvent(NFC_EVENT_WRITE_DONE, false, uidString, "", batch->isSpoolTag);
+    return;
+  }
+
+  for (uint16_t i = 0; i < batch->written; i++) {
+    if (memcmp(batch->writtenUids[i], uid, 7) == 0) {
+      Serial.println("Tag wurde in diesem Batch bereits geschrieben");
+      oledShowProgressBar(batch->written, batch->count, "Batch", "Already written");
+      nfcReaderState = NFC_WRITE_SUCCESS;
+      return;
+    }
+  }
+
+  NfcCommand command = {};
+  command.type = NFC_CMD_WRITE;
+  command.isSpoolTag = batch->isSpoolTag;
+  command.slot = batch->slot;
+  size_t payloadLength = strlen(batch->nextPayload);
+  memcpy(command.slot->payload, batch->nextPayload, payloadLength + 1);
+  prepareWriteRecord(command, payloadLength, batch->format);
+
+  emitNfcEvent(NFC_EVENT_WRITE_STARTED, true, uidString, command.slot->payload, command.isSpoolTag);
+  oledShowProgressBar(batch->written, batch->count, "Batch", "Writing");
+
+  bool success = writeCommandToTag(command, uid, uidLength);
+  if (success) {
+    memcpy(batch->writtenUids[batch->written], uid, 7);
+    batch->written++;
+    batch->nextPayload += payloadLength + 1;
+    nfcReaderState = NFC_WRITE_SUCCESS;
+  } else {
+    // The payload stays for the next tag
+    nfcReaderState = NFC_WRITE_ERROR;
+  }
+
+  Serial.printf("Batch: Tag %u/%u %s\n", (unsigned int)batch->written, (unsigned int)batch->count, success ? "geschrieben" : "fehlgeschlagen");
+  oledShowProgressBar(batch->written, batch->count, "Batch", success ? "Next tag" : "Write failed");
+  // Spoolman is updated by the API subscriber
+  emitNfcEvent(NFC_EVENT_WRITE_DONE, success, uidString, command.slot->payload, command.isSpoolTag);
+
+  if (batch->written == batch->count) {
+    finishBatchWrite(true);
+  }
+}
+
+void handleNfcCommand(const NfcCommand& command) {
+  switch (command.type) {
+    case NFC_CMD_SCAN:
+      nfcRescanRequested = true;
+      break;
+    case NFC_CMD_WRITE:
+      cancelIrqTagDetection();
+      writeJsonToTag(command);
+      break;
+    case NFC_CMD_BATCH_START:
+      // A new batch replaces the running one
+      finishBatchWrite(false);
+      nfcBatch = command.batch;
+      Serial.printf("Batch gestartet: %u Tags\n", (unsigned int)nfcBatch->count);
+      oledShowProgressBar(0, nfcBatch->count, "Batch", "Place tag now");
+      // A tag already on the reader is the first one of the batch
+      nfcRescanRequested = true;
+      break;
+    case NFC_CMD_BATCH_STOP:
+      finishBatchWrite(false);
+      break;
+    case NFC_CMD_SUSPEND:
+      cancelIrqTagDetection();
+      nfcSuspended = true;
+      Serial.println("NFC Reading disabled");
+      break;
+    case NFC_CMD_RESUME:
+      nfcSuspended = false;
+      Serial.println("NFC Reading enabled");
+      break;
+  }
+}
+
+// One detection round: processes a new tag and notices its removal
+void scanForTag() {
+  uint8_t success;
+  uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
+  uint8_t uidLength;
+
+  bool dutyCycle = dutyCycleActive();
+  if (!dutyCycle && nfcRfFieldOff) setRfField(true);
+
+  unsigned long detectionStart = micros();
+  // Wait for a card interrupt while idle, tag removal is still detected by polling
+  if (dutyCycle) {
+    success = dutyCycleTagDetection(uid, &uidLength);
+  } else if (nfcReaderCount > 1 && nfcReaderState == NFC_IDLE) {
+    success = muxTagDetection(uid, &uidLength);
+  } else if (PN532_IRQ_ENABLED && nfcReaderState == NFC_IDLE) {
+    success = irqTagDetection(uid, &uidLength);
+  } else if (nfcReaderState != NFC_IDLE && nfcPresentUidLength > 0) {
+    success = checkTagPresence(uid, &uidLength);
+  } else {
+    // Use safe tag detection instead of blocking readPassiveTargetID
+    success = safeTagDetection(uid, &uidLength);
+  }
+  
+  unsigned long tagFoundAt = micros();
+
+  // Reset activeSpoolId immediately when no tag is detected to prevent stale autoSet
+  if (!success) {
+    setActiveSpool(0);
+  } else {
+    nfcLastActivity = millis();
+  }
+
+  // Another tag took the place of the processed one: report the removal and read the new one right away
+  bool tagReplaced = success && nfcReaderState != NFC_IDLE && nfcPresentUidLength > 0 &&
+                     (uidLength != nfcPresentUidLength || memcmp(uid, nfcPresentUid, uidLength) != 0);
+
+  if ((!success || tagReplaced) && nfcReaderState != NFC_IDLE)
+  {
+    nfcReaderState = NFC_IDLE;
+    nfcRescanRequested = false;
+    nfcPresentUidLength = 0;
+    nfcJsonData[0] = '\0';
+    setActiveSpool(0);
+    Serial.println("Tag entfernt");
+    if (!bambuCredentials.autosend_enable) oledShowWeight(weight);
+    emitNfcEvent(NFC_EVENT_TAG_REMOVED, true);
+  }
+  
+  // As long as the same tag is on the reader, do not try to read it again
+  if (success && (nfcReaderState == NFC_IDLE || nfcRescanRequested))
+  {
+    // A rescan of the tag on the reader found it by a presence check, no detection to count
+    if (nfcReaderState == NFC_IDLE) nfcLatencyRecord(NFC_PHASE_DETECTION, tagFoundAt - detectionStart);
+    nfcRescanRequested = false;
+    rememberPresentTag(uid, uidLength);
+
+    // Display some basic information about the card
+    Serial.println("Found an ISO14443A card");
+
+    // create Tag UID string
+    char uidString[NFC_UID_STRING_SIZE];
+    formatUid(uid, uidLength, uidString);
+
+    // Batch programming: a new tag on the scale reader is written instead of read
+    if (nfcBatch != NULL && nfcSelectedReader == NFC_SCALE_READER) {
+      writeNextBatchTag(uid, uidLength, uidString);
+      return; // Presence checks take over from here
+    }
+
+    nfcReaderState = NFC_READING;
+    emitNfcEvent(NFC_EVENT_TAG_ARRIVED, true, uidString);
+
+    oledShowProgressBar(0, octoEnabled?5:4, "Reading", "Detecting tag");
+
+    // Reduced stabilization time for better responsiveness
+    Serial.println("Tag detected, minimal stabilization...");
+    unsigned long phaseStart = micros();
+    vTaskDelay(200 / portTICK_PERIOD_MS); // Reduced from 1000ms to 200ms
+    nfcLatencyRecord(NFC_PHASE_STABILIZATION, micros() - phaseStart);
+    
+    if (uidLength == 7)
+    {
+      // Tag type is needed for every read below, known UIDs come from the capability cache
+      phaseStart = micros();
+      bool tagDetected = detectTagCapability(uid, uidLength, &currentTag);
+      nfcLatencyRecord(NFC_PHASE_CAPABILITY, micros() - phaseStart);
+
+      // Known UID: the checksum in pages 4-5 tells whether the cached fields are still current.
+      // A tag rewritten elsewhere, e.g. by a phone app, no longer carries the checksum we cached.
+      TagCacheEntry cached;
+      uint32_t checksum = 0;
+      phaseStart = micros();
+      if (tagDetected && spoolmanConnected && tagCacheLookup(uid, uidLength, &cached)) {
+        bool cacheValid = readTagChecksum(&checksum) && checksum == cached.payloadCrc;
+        nfcLatencyRecord(NFC_PHASE_FAST_PATH, micros() - phaseStart);
+        if (cacheValid) {
+          tagCacheToJson(&cached, nfcJsonData, sizeof(nfcJsonData));
+          if (cached.smId == 0) {
+            Serial.print("✓ CACHE: Location ");
+            Serial.println(cached.location);
+            locationScanned(cached.location);
+          } else {
+            Serial.print("✓ CACHE: Known spool ");
+            Serial.println(cached.smId);
+            oledShowProgressBar(2, octoEnabled?5:4, "Known Spool", "Cached");
+            spoolScanned(cached.smId);
           }
+          nfcReaderState = NFC_READ_SUCCESS;
+          nfcLatencyRecord(NFC_PHASE_READ_TOTAL, micros() - tagFoundAt);
+          emitNfcEvent(NFC_EVENT_READ_DONE, true, uidString, nfcJsonData);
+          return; // Presence checks take over from here
         }
-        else
-        {
-          //TBD: Show error here?!
-          oledShowProgressBar(1, 1, "Failure", "Unkown tag type");
-          Serial.println("This doesn't seem to be an NTAG2xx tag (UUID length != 7 bytes)!");
-          // Reset activeSpoolId when tag type is unknown to prevent autoSet
-          activeSpoolId = "";
-          Serial.println("Unknown tag type - activeSpoolId reset to prevent autoSet");
-        }
+        Serial.println("CACHE: Prüfsumme passt nicht mehr, Tag wird gelesen");
       }
 
-      if (!success && nfcReaderState != NFC_IDLE && !nfcReadingTaskSuspendRequest)
+      if (tagDetected)
       {
-        nfcReaderState = NFC_IDLE;
-        //uidString = "";
-        nfcJsonData = "";
-        activeSpoolId = "";
-        Serial.println("Tag entfernt");
-        if (!bambuCredentials.autosend_enable) oledShowWeight(weight);
+        phaseStart = micros();
+        bool readOk = readTagOnDemand(uidString, &checksum);
+        nfcLatencyRecord(NFC_PHASE_FULL_READ, micros() - phaseStart);
+        if (readOk)
+        {
+          tagCacheStore(uid, uidLength, nfcJsonData, strlen(nfcJsonData), checksum);
+          nfcReaderState = NFC_READ_SUCCESS;
+          nfcLatencyRecord(NFC_PHASE_READ_TOTAL, micros() - tagFoundAt);
+          emitNfcEvent(NFC_EVENT_READ_DONE, true, uidString, nfcJsonData);
+          return; // Presence checks take over from here
+        }
+
+        oledShowProgressBar(1, 1, "Failure", "Unknown tag");
+        nfcReaderState = NFC_READ_ERROR;
       }
-      // Reset state after successful read when tag is removed
-      else if (!success && nfcReaderState == NFC_READ_SUCCESS)
+      else
       {
-        nfcReaderState = NFC_IDLE;
-        Serial.println("Tag nach erfolgreichem Lesen entfernt - bereit für nächsten Tag");
-      }
-
-      // Add a pause after successful reading to prevent immediate re-reading
-      if (nfcReaderState == NFC_READ_SUCCESS) {
-        Serial.println("Tag erfolgreich gelesen - warte 3 Sekunden vor nächstem Scan");
-        vTaskDelay(3000 / portTICK_PERIOD_MS); // Reduced from 5 seconds to 3 seconds
-      } else {
-        // Faster scanning when no tag or idle state
-        vTaskDelay(150 / portTICK_PERIOD_MS); // Faster scan interval
+        oledShowProgressBar(1, 1, "Failure", "Tag read error");
+        nfcReaderState = NFC_READ_ERROR;
+        // Reset activeSpoolId when tag reading fails to prevent autoSet
+        setActiveSpool(0);
+        Serial.println("Tag read failed - activeSpoolId reset to prevent autoSet");
       }
-
-      // aktualisieren der Website wenn sich der Status ändert
-      sendNfcData();
     }
     else
     {
-      nfcReadingTaskSuspendState = true;
-      
-      // Different behavior for write protection vs. full suspension
-      if (nfcWriteInProgress) {
-        // During write: Just pause scanning, don't disable NFC interface
-        // Serial.println("NFC Scanning paused during write operation");
-        vTaskDelay(100 / portTICK_PERIOD_MS); // Shorter delay during write
-      } else {
-        // Full suspension requested
-        Serial.println("NFC Reading disabled");
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-      }
+      //TBD: Show error here?!
+      oledShowProgressBar(1, 1, "Failure", "Unkown tag type");
+      Serial.println("This doesn't seem to be an NTAG2xx tag (UUID length != 7 bytes)!");
+      nfcReaderState = NFC_READ_ERROR;
+      // Reset activeSpoolId when tag type is unknown to prevent autoSet
+      setActiveSpool(0);
+      Serial.println("Unknown tag type - activeSpoolId reset to prevent autoSet");
     }
-    yield();
+
+    nfcLatencyRecord(NFC_PHASE_READ_TOTAL, micros() - tagFoundAt);
+    emitNfcEvent(NFC_EVENT_READ_DONE, nfcReaderState == NFC_READ_SUCCESS, uidString, nfcJsonData);
+  }
+}
+
+// Pause of a single reader after its scan, depends on what the scan left behind
+void waitForNextScan() {
+  if (nfcReaderState != NFC_IDLE && nfcPresentUidLength > 0) {
+    // Tag stays on the reader, only its removal or replacement is of interest
+    waitForNfcCommand(NFC_PRESENCE_CHECK_INTERVAL);
+  } else if (nfcRfFieldOff) {
+    waitForDutyCycle();
+  } else if (!nfcIrqListening) {
+    // Faster scanning when no tag or idle state
+    waitForNfcCommand(150); // Faster scan interval
+  }
+}
+
+// Several readers: one turn per reader and round, a turn only waits for a tag that is being read.
+// The round starts one reader later each time, so a long read does not always delay the same readers.
+void scanReaders() {
+  for (uint8_t turn = 0; turn < nfcReaderCount; turn++) {
+    selectReader((nfcRoundStart + turn) % nfcReaderCount);
+    scanForTag();
+    if (uxQueueMessagesWaiting(nfcCommandQueue) > 0) break; // Commands first
   }
+  nfcRoundStart = (nfcRoundStart + 1) % nfcReaderCount;
+  waitForNfcCommand(NFC_READER_ROUND_INTERVAL);
+}
+
+// One round of the owner task: runs queued commands and scans for tags in between
+void nfcTaskStep() {
+  NfcCommand command;
+
+  // Regular watchdog reset
+  esp_task_wdt_reset();
+  yield();
+
+  // Commands first, a write must not wait for the next tag read. They all go to the scale reader.
+  while (xQueueReceive(nfcCommandQueue, &command, 0) == pdTRUE) {
+    nfcLastActivity = millis();
+    selectReader(NFC_SCALE_READER);
+    if (nfcRfFieldOff) setRfField(true);
+    handleNfcCommand(command);
+  }
+
+  if (nfcSuspended || booting) {
+    selectReader(NFC_SCALE_READER);
+    cancelIrqTagDetection();
+    // booting ends without a command, so check again after a while
+    if (xQueueReceive(nfcCommandQueue, &command, pdMS_TO_TICKS(1000)) == pdTRUE) {
+      handleNfcCommand(command);
+    }
+    return;
+  }
+
+  if (nfcReaderCount > 1) {
+    scanReaders();
+  } else {
+    scanForTag();
+    waitForNextScan();
+  }
+
+  // Persist cache changes once the readers have been quiet for a while
+  tagCacheFlush(false);
+}
+
+// Owner of the PN532
+void scanRfidTask(void * parameter) {
+  Serial.println("RFID Task gestartet");
+  for(;;) {
+    nfcTaskStep();
+  }
+}
+
+bool nfcSetReaders(const NfcReaderConfig* readers, uint8_t count) {
+  if (count == 0 || count > NFC_MAX_READERS) return false;
+  if (count > 1 && PN532_TRANSPORT != PN532_TRANSPORT_I2C) {
+    Serial.println("Mehrere NFC-Reader nur über I2C - nur der Waagen-Reader wird verwendet");
+    count = 1;
+  }
+
+  // The scale reader goes on with its tag, without pending detection and with the field on
+  selectReader(NFC_SCALE_READER);
+  cancelIrqTagDetection();
+  if (nfcRfFieldOff) setRfField(true);
+  nfcReaders[NFC_SCALE_READER].config = readers[0];
+  nfcReaders[NFC_SCALE_READER].pn532 = nfc;
+
+  bool restarted = false;
+  for (uint8_t i = 1; i < count; i++) {
+    NfcReader& reader = nfcReaders[i];
+    reader.config = readers[i];
+    reader.state = NFC_IDLE;
+    reader.presentUidLength = 0;
+    reader.rescanRequested = false;
+    reader.irqListening = false;
+
+    // Drivers are kept, a reader that comes back uses its old one
+    if (reader.pn532 == NULL) {
+      selectMuxChannel(reader.config.muxChannel);
+      reader.pn532 = createPn532(reader.config.irqPin);
+      reader.pn532->begin();
+      restarted = true;
+    }
+  }
+
+  nfcReaderCount = count;
+  nfcRoundStart = 0;
+  selectMuxChannel(readers[0].muxChannel);
+  if (restarted) {
+    // begin() of a new driver pulsed the common reset line
+    Wire.setClock(PN532_I2C_CLOCK);
+    nfc->SAMConfig();
+  }
+  restartOtherReaders();
+
+  Serial.printf("NFC-Reader: %u\n", (unsigned int)nfcReaderCount);
+  return true;
 }
 
 void startNfc() {
   oledShowProgressBar(5, 7, DISPLAY_BOOT_TEXT, "NFC init");
-  nfc.begin();                                           // Beginne Kommunikation mit RFID Leser
+  beginPn532();                                          // Beginne Kommunikation mit RFID Leser
   delay(1000);
-  unsigned long versiondata = nfc.getFirmwareVersion();  // Lese Versionsnummer der Firmware aus
+  unsigned long versiondata = nfc->getFirmwareVersion();  // Lese Versionsnummer der Firmware aus
   if (! versiondata) {                                   // Wenn keine Antwort kommt
     Serial.println("Kann kein RFID Board finden !");            // Sende Text "Kann kein..." an seriellen Monitor
     oledShowMessage("No RFID Board found");
@@ -2090,12 +2389,22 @@ void startNfc() {
     Serial.print("Firmware ver. "); Serial.print((versiondata >> 16) & 0xFF, DEC);      // Monitor, wenn Antwort vom Board kommt
     Serial.print('.'); Serial.println((versiondata >> 8) & 0xFF, DEC);                  // 
 
-    nfc.SAMConfig();
+    nfc->SAMConfig();
+    if (!nfcSetReaders(NFC_READERS, NFC_READER_COUNT)) {
+      Serial.println("NFC_READERS ungültig - nur der Waagen-Reader wird verwendet");
+    }
+    tagCacheBegin();
+    nfcCommandQueue = xQueueCreate(NFC_COMMAND_QUEUE_LENGTH, sizeof(NfcCommand));
+    nfcFreeSlotQueue = xQueueCreate(NFC_WRITE_SLOT_COUNT, sizeof(NfcWriteSlot*));
+    for (uint8_t i = 0; i < NFC_WRITE_SLOT_COUNT; i++) {
+      NfcWriteSlot* slot = &nfcWriteSlots[i];
+      xQueueSend(nfcFreeSlotQueue, &slot, 0);
+    }
     // Set the max number of retry attempts to read from a card
     // This prevents us from waiting forever for a card, which is
     // the default behaviour of the PN532.
-    //nfc.setPassiveActivationRetries(0x7F);
-    //nfc.setPassiveActivationRetries(0xFF);
+    //nfc->setPassiveActivationRetries(0x7F);
+    //nfc->setPassiveActivationRetries(0xFF);
 
     BaseType_t result = xTaskCreatePinnedToCore(
       scanRfidTask, /* Function to implement the task */
@@ -2110,6 +2419,12 @@ void startNfc() {
         Serial.println("Fehler beim Erstellen des RFID Tasks");
     } else {
         Serial.println("RFID Task erfolgreich erstellt");
+
+        // Shelf readers are polled through their IRQ lines, the interrupt only serves a single reader
+        if (PN532_IRQ_ENABLED && nfcReaderCount == 1) {
+          attachInterrupt(digitalPinToInterrupt(PN532_IRQ), nfcIrqHandler, FALLING);
+          Serial.println("NFC IRQ-Erkennung aktiv");
+        }
     }
   }
 }
\ No newline at end of file
@@ -2,6 +2,12 @@
 #define NFC_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+#define NFC_SCALE_READER 0  // Reader under the scale, the first entry of NFC_READERS
+#define NFC_UID_STRING_SIZE 21  // 7 bytes as hex separated by ':', with terminator
+#define NFC_JSON_DATA_SIZE 889  // NTAG216 user memory with terminator, the longest JSON a tag can give
 
 typedef enum{
     NFC_IDLE,
@@ -13,20 +19,63 @@ typedef enum{
     NFC_WRITE_ERROR
 } nfcReaderStateType;
 
+typedef enum{
+    NFC_FORMAT_JSON,
+    NFC_FORMAT_CBOR
+} nfcPayloadFormatType;
+
+// Commands for the NFC task, the only task that talks to the PN532
+typedef enum{
+    NFC_CMD_SCAN,       // Process the tag on the reader again, even if it was already read
+    NFC_CMD_WRITE,
+    NFC_CMD_BATCH_START,    // Every newly presented tag gets the next payload of the batch
+    NFC_CMD_BATCH_STOP,
+    NFC_CMD_SUSPEND,
+    NFC_CMD_RESUME
+} nfcCommandType;
+
+typedef enum{
+    NFC_EVENT_TAG_ARRIVED,
+    NFC_EVENT_READ_DONE,
+    NFC_EVENT_WRITE_STARTED,
+    NFC_EVENT_WRITE_DONE,
+    NFC_EVENT_TAG_REMOVED,
+    NFC_EVENT_BATCH_DONE    // All payloads written (success) or batch cancelled
+} nfcEventType;
+
+typedef struct {
+    nfcEventType type;
+    nfcReaderStateType state;   // Reader state after the event
+    bool success;
+    bool isSpoolTag;            // Write events only
+    const char* uid;            // Only valid during the callback
+    const char* payload;        // JSON of the tag, only valid during the callback
+    uint16_t batchWritten;      // Tags written by the running batch
+    uint16_t batchTotal;        // Payloads of the running batch, 0 outside of a batch
+    uint8_t reader;             // Reader that saw the tag, NFC_SCALE_READER for the scale
+} NfcEvent;
+
+// Called from the NFC task, must not block
+typedef void (*NfcEventCallback)(const NfcEvent& event);
+
 void startNfc();
+bool nfcSetReaders(const NfcReaderConfig* readers, uint8_t count); // Called by startNfc, the simulator changes the readers at runtime
 void scanRfidTask(void * parameter);
-void startWriteJsonToTag(const bool isSpoolTag, const char* payload);
-bool quickSpoolIdCheck(String uidString);
-bool readCompleteJsonForFastPath(); // Read complete JSON data for fast-path web interface display
+void nfcTaskStep(); // One round of the NFC task, the host simulator drives it directly
+bool nfcSubscribe(NfcEventCallback callback);
+bool nfcSendCommand(nfcCommandType type, uint32_t timeoutMs = 0); // Waits up to timeoutMs while the command queue is full
+void startWriteJsonToTag(const bool isSpoolTag, const char* payload, nfcPayloadFormatType format = NFC_FORMAT_JSON);
+bool startBatchWrite(const bool isSpoolTag, JsonArrayConst payloads, nfcPayloadFormatType format = NFC_FORMAT_JSON);
+bool stopBatchWrite();
+void nfcWeightStep(); // Called by the scale task when the load changes, ends the slow duty cycle polling
+bool readTagOnDemand(const char* uidString, uint32_t* checksum); // Reads only the pages the tag kind needs, sets nfcJsonData
 
 extern TaskHandle_t RfidReaderTask;
-extern String nfcJsonData;
-extern String activeSpoolId;
-extern String lastSpoolId;
-extern volatile nfcReaderStateType nfcReaderState;
-extern volatile bool pauseBambuMqttTask;
-extern volatile bool nfcWriteInProgress;
-extern bool tagProcessed;
+extern char nfcJsonData[];         // JSON of the tag on the reader, empty if there is none
+extern uint32_t activeSpoolId;      // Spoolman ID of the spool on the reader, 0 if there is none
+extern uint32_t lastSpoolId;        // Spool waiting for a location tag, 0 if there is none
+extern uint16_t nfcPagesWritten;
+extern uint16_t nfcPagesSkipped;
 
 
 
@@ -0,0 +1,77 @@
+#include "nfcLatency.h"
+#include <ArduinoJson.h>
+
+typedef struct {
+    uint32_t count;
+    uint64_t totalMicros;       // 64 bit, 32 bit would wrap after about 71 minutes of one phase
+    uint32_t maxMicros;
+    uint32_t buckets[NFC_LATENCY_BUCKET_COUNT];
+} NfcPhaseHistogram;
+
+// Upper bounds of the buckets in ms, the last bucket takes everything above
+static const uint16_t BUCKET_LIMITS[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+static_assert(sizeof(BUCKET_LIMITS) / sizeof(BUCKET_LIMITS[0]) == NFC_LATENCY_BUCKET_COUNT - 1, "one limit per bucket but the last");
+
+static const char* const PHASE_NAMES[NFC_PHASE_COUNT] = {
+    "detection",
+    "stabilization",
+    "capability",
+    "fastPath",
+    "fullRead",
+    "decode",
+    "readTotal",
+    "spoolman",
+    "writeCheck",
+    "writeRead",
+    "writePages",
+    "writeVerify",
+    "writeHeader",
+    "writeTotal",
+};
+
+static NfcPhaseHistogram histograms[NFC_PHASE_COUNT];
+static unsigned long resetAt = 0;
+
+void nfcLatencyRecord(nfcPhaseType phase, uint32_t micros) {
+    if (phase >= NFC_PHASE_COUNT) return;
+
+    uint8_t bucket = 0;
+    uint32_t ms = micros / 1000;
+    while (bucket < NFC_LATENCY_BUCKET_COUNT - 1 && ms >= BUCKET_LIMITS[bucket]) bucket++;
+
+    NfcPhaseHistogram& histogram = histograms[phase];
+    histogram.count++;
+    histogram.totalMicros += micros;
+    if (micros > histogram.maxMicros) histogram.maxMicros = micros;
+    histogram.buckets[bucket]++;
+}
+
+void nfcLatencyReset() {
+    memset(histograms, 0, sizeof(histograms));
+    resetAt = millis();
+}
+
+String nfcLatencyToJson() {
+    JsonDocument doc;
+    doc["since"] = (millis() - resetAt) / 1000;
+
+    // Bucket i counts samples below limits[i] ms and at or above the limit before it
+    JsonArray limits = doc["limits"].to<JsonArray>();
+    for (uint8_t i = 0; i < NFC_LATENCY_BUCKET_COUNT - 1; i++) limits.add(BUCKET_LIMITS[i]);
+
+    JsonObject phases = doc["phases"].to<JsonObject>();
+    for (uint8_t i = 0; i < NFC_PHASE_COUNT; i++) {
+        const NfcPhaseHistogram& histogram = histograms[i];
+        JsonObject phase = phases[PHASE_NAMES[i]].to<JsonObject>();
+        phase["count"] = histogram.count;
+        phase["meanUs"] = histogram.count > 0 ? (uint32_t)(histogram.totalMicros / histogram.count) : 0;
+        phase["maxUs"] = histogram.maxMicros;
+
+        JsonArray buckets = phase["buckets"].to<JsonArray>();
+        for (uint8_t j = 0; j < NFC_LATENCY_BUCKET_COUNT; j++) buckets.add(histogram.buckets[j]);
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
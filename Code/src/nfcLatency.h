@@ -0,0 +1,32 @@
+#ifndef NFCLATENCY_H
+#define NFCLATENCY_H
+
+#include <Arduino.h>
+
+#define NFC_LATENCY_BUCKET_COUNT    13      // Fixed bucket limits from 1 ms to 5 s and one bucket above
+
+typedef enum {
+    NFC_PHASE_DETECTION,        // Detection call that found a tag (poll, IRQ or presence check)
+    NFC_PHASE_STABILIZATION,    // Pause after a new tag before it is read
+    NFC_PHASE_CAPABILITY,       // Tag type from GET_VERSION or the capability cache
+    NFC_PHASE_FAST_PATH,        // Checksum read and tag cache lookup of a known UID
+    NFC_PHASE_FULL_READ,        // On-demand read of the NDEF area, includes the decode
+    NFC_PHASE_DECODE,           // Decode of a record that needs the complete payload (brand filament, CBOR)
+    NFC_PHASE_READ_TOTAL,       // New tag until its read event
+    NFC_PHASE_SPOOLMAN,         // Spool request to Spoolman after a read
+    NFC_PHASE_WRITE_CHECK,      // Interface check before a write
+    NFC_PHASE_WRITE_READ,       // Bulk read of the current content for the diff
+    NFC_PHASE_WRITE_PAGES,      // Page writes behind the header
+    NFC_PHASE_WRITE_VERIFY,     // Read-back of the written pages
+    NFC_PHASE_WRITE_HEADER,     // Header page that makes the record valid
+    NFC_PHASE_WRITE_TOTAL,      // Write command until the tag holds the record
+    NFC_PHASE_COUNT
+} nfcPhaseType;
+
+// Called from the NFC task and the Spoolman tasks. Read and reset by the web server without
+// locking, a sample recorded during a reset can be lost.
+void nfcLatencyRecord(nfcPhaseType phase, uint32_t micros);
+void nfcLatencyReset();
+String nfcLatencyToJson();
+
+#endif
@@ -4,6 +4,7 @@
 #include "scale.h"
 #include "bambu.h"
 #include "nfc.h"
+#include "config.h"
 
 
 // Globale Variablen für Config Backups hinzufügen
@@ -170,6 +171,7 @@ void handleUpdate(AsyncWebServer &server) {
         }
         if (RfidReaderTask) {
             Serial.println("Delete RfidReaderTask");
+            if (PN532_IRQ_ENABLED) detachInterrupt(digitalPinToInterrupt(PN532_IRQ));
             vTaskDelete(RfidReaderTask);
             RfidReaderTask = NULL;
         }
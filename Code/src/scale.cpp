@@ -1,4 +1,5 @@
 #include "nfc.h"
+#include "bambu.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "config.h"
@@ -180,6 +181,11 @@ void scale_loop(void * parameter) {
 
         // Get raw weight reading
         float rawWeight = scale.get_units();
+
+        // A spool put on or taken off switches the NFC reader to fast polling before the filter settles
+        static float lastRawWeight = 0;
+        if (fabs(rawWeight - lastRawWeight) >= NFC_WAKE_WEIGHT_STEP) nfcWeightStep();
+        lastRawWeight = rawWeight;
         
         // Process weight with stabilization
         int16_t stabilizedWeight = processWeightReading(rawWeight);
@@ -285,7 +291,12 @@ uint8_t calibrate_scale() {
 
   scaleCalibrationActive = true;
 
-  if (RfidReaderTask != NULL) vTaskSuspend(RfidReaderTask);
+  // Calibrating with the reader still polling would disturb the measurement
+  if (!nfcSendCommand(NFC_CMD_SUSPEND, NFC_COMMAND_SEND_TIMEOUT)) {
+    Serial.println("Fehler: NFC konnte nicht angehalten werden, Kalibrierung abgebrochen");
+    scaleCalibrationActive = false;
+    return 0;
+  }
   if (ScaleTask != NULL) vTaskSuspend(ScaleTask);
 
   pauseBambuMqttTask = true;
@@ -393,7 +404,11 @@ uint8_t calibrate_scale() {
     returnState = 0;
   }
 
-  if (RfidReaderTask != NULL) vTaskResume(RfidReaderTask);
+  // A lost resume would keep the reader off until the next reboot
+  while (!nfcSendCommand(NFC_CMD_RESUME, NFC_COMMAND_SEND_TIMEOUT)) {
+    Serial.println("Fehler: NFC konnte nicht fortgesetzt werden, neuer Versuch");
+    esp_task_wdt_reset();
+  }
   if (ScaleTask != NULL) vTaskResume(ScaleTask);
   pauseBambuMqttTask = false;
   pauseMainTask = 0;
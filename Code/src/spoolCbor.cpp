@@ -0,0 +1,214 @@
+#include "spoolCbor.h"
+#include <string.h>
+
+#define CBOR_MAJOR_UNSIGNED         0x00
+#define CBOR_MAJOR_NEGATIVE         0x20
+#define CBOR_MAJOR_TEXT             0x60
+#define CBOR_MAJOR_MAP              0xA0
+#define CBOR_FALSE                  0xF4
+#define CBOR_TRUE                   0xF5
+#define CBOR_NULL                   0xF6
+#define CBOR_FLOAT32                0xFA
+#define CBOR_FLOAT64                0xFB
+
+// Integer keys, the index is the key. Keys that are not listed are stored as text.
+static const char* const SPOOL_CBOR_KEYS[] = {
+    "sm_id", "location", "brand", "type", "color_hex", "min_temp", "max_temp",
+    // Manufacturer tag short keys
+    "b", "an", "t", "c", "mc", "mcd", "cn", "et", "bt", "di", "de", "sw", "u"
+};
+static const uint8_t SPOOL_CBOR_KEY_COUNT = sizeof(SPOOL_CBOR_KEYS) / sizeof(SPOOL_CBOR_KEYS[0]);
+
+static int keyIndex(const char* key) {
+    for (uint8_t i = 0; i < SPOOL_CBOR_KEY_COUNT; i++) {
+        if (strcmp(SPOOL_CBOR_KEYS[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+// Writes a type/length header with the shortest argument encoding
+static bool writeHead(uint8_t major, uint64_t value, uint8_t* buffer, size_t bufferSize, size_t* offset) {
+    uint8_t argumentBytes = value < 24 ? 0 : value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFFFFULL ? 4 : 8;
+    if (*offset + 1 + argumentBytes > bufferSize) return false;
+
+    if (argumentBytes == 0) {
+        buffer[(*offset)++] = major | (uint8_t)value;
+        return true;
+    }
+
+    buffer[(*offset)++] = major | (argumentBytes == 1 ? 24 : argumentBytes == 2 ? 25 : argumentBytes == 4 ? 26 : 27);
+    for (int8_t i = argumentBytes - 1; i >= 0; i--) {
+        buffer[(*offset)++] = (uint8_t)(value >> (i * 8));
+    }
+    return true;
+}
+
+static bool writeText(const char* text, size_t length, uint8_t* buffer, size_t bufferSize, size_t* offset) {
+    if (!writeHead(CBOR_MAJOR_TEXT, length, buffer, bufferSize, offset)) return false;
+    if (*offset + length > bufferSize) return false;
+    memcpy(&buffer[*offset], text, length);
+    *offset += length;
+    return true;
+}
+
+size_t spoolCborEncode(JsonObjectConst object, uint8_t* buffer, size_t bufferSize) {
+    size_t entries = object.size();
+    bool hasSpoolId = !object["sm_id"].isNull();
+    if (!hasSpoolId) entries++;
+    if (entries > SPOOL_CBOR_MAX_ENTRIES || bufferSize < SPOOL_CBOR_SM_ID_OFFSET + 4) return 0;
+
+    // Map header, key 0 and the fixed width sm_id
+    uint32_t smId = hasSpoolId ? object["sm_id"].as<String>().toInt() : 0;
+    size_t offset = 0;
+    buffer[offset++] = CBOR_MAJOR_MAP | (uint8_t)entries;
+    buffer[offset++] = CBOR_MAJOR_UNSIGNED | 0;
+    buffer[offset++] = CBOR_MAJOR_UNSIGNED | 26;
+    buffer[offset++] = (uint8_t)(smId >> 24);
+    buffer[offset++] = (uint8_t)(smId >> 16);
+    buffer[offset++] = (uint8_t)(smId >> 8);
+    buffer[offset++] = (uint8_t)smId;
+
+    for (JsonPairConst kv : object) {
+        const char* key = kv.key().c_str();
+        if (strcmp(key, "sm_id") == 0) continue;
+
+        int index = keyIndex(key);
+        bool keyWritten = index >= 0
+            ? writeHead(CBOR_MAJOR_UNSIGNED, index, buffer, bufferSize, &offset)
+            : writeText(key, strlen(key), buffer, bufferSize, &offset);
+        if (!keyWritten) return 0;
+
+        JsonVariantConst value = kv.value();
+        bool valueWritten;
+        if (value.is<const char*>()) {
+            const char* text = value.as<const char*>();
+            valueWritten = writeText(text, strlen(text), buffer, bufferSize, &offset);
+        } else if (value.is<bool>()) {
+            valueWritten = offset < bufferSize;
+            if (valueWritten) buffer[offset++] = value.as<bool>() ? CBOR_TRUE : CBOR_FALSE;
+        } else if (value.is<long long>()) {
+            long long number = value.as<long long>();
+            valueWritten = number >= 0
+                ? writeHead(CBOR_MAJOR_UNSIGNED, (uint64_t)number, buffer, bufferSize, &offset)
+                : writeHead(CBOR_MAJOR_NEGATIVE, (uint64_t)(-1 - number), buffer, bufferSize, &offset);
+        } else if (value.is<double>()) {
+            double number = value.as<double>();
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            valueWritten = offset + 9 <= bufferSize;
+            if (valueWritten) {
+                buffer[offset++] = CBOR_FLOAT64;
+                for (int8_t i = 7; i >= 0; i--) buffer[offset++] = (uint8_t)(bits >> (i * 8));
+            }
+        } else if (value.isNull()) {
+            valueWritten = offset < bufferSize;
+            if (valueWritten) buffer[offset++] = CBOR_NULL;
+        } else {
+            // Nested objects and arrays are not part of the spool format
+            valueWritten = false;
+        }
+        if (!valueWritten) return 0;
+    }
+
+    return offset;
+}
+
+// Reads a type/length header, returns false if it is cut off or uses indefinite length
+static bool readHead(const uint8_t* data, size_t length, size_t* offset, uint8_t* major, uint64_t* value) {
+    if (*offset >= length) return false;
+
+    uint8_t initial = data[(*offset)++];
+    uint8_t info = initial & 0x1F;
+    *major = initial & 0xE0;
+
+    if (info < 24) {
+        *value = info;
+        return true;
+    }
+
+    uint8_t argumentBytes = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : info == 27 ? 8 : 0;
+    if (argumentBytes == 0 || *offset + argumentBytes > length) return false;
+
+    *value = 0;
+    for (uint8_t i = 0; i < argumentBytes; i++) {
+        *value = (*value << 8) | data[(*offset)++];
+    }
+    return true;
+}
+
+bool spoolCborDecode(const uint8_t* data, size_t length, JsonDocument& doc) {
+    size_t offset = 0;
+    uint8_t major;
+    uint64_t entries;
+
+    if (!readHead(data, length, &offset, &major, &entries) || major != CBOR_MAJOR_MAP) return false;
+
+    doc.clear();
+    for (uint64_t entry = 0; entry < entries; entry++) {
+        uint64_t argument;
+        String key;
+
+        if (!readHead(data, length, &offset, &major, &argument)) return false;
+        if (major == CBOR_MAJOR_UNSIGNED && argument < SPOOL_CBOR_KEY_COUNT) {
+            key = SPOOL_CBOR_KEYS[argument];
+        } else if (major == CBOR_MAJOR_TEXT && offset + argument <= length) {
+            key = String((const char*)&data[offset], argument);
+            offset += argument;
+        } else {
+            return false;
+        }
+
+        if (offset >= length) return false;
+        uint8_t initial = data[offset];
+
+        if (initial == CBOR_FALSE || initial == CBOR_TRUE) {
+            doc[key] = initial == CBOR_TRUE;
+            offset++;
+        } else if (initial == CBOR_NULL) {
+            doc[key] = nullptr;
+            offset++;
+        } else if (initial == CBOR_FLOAT64 || initial == CBOR_FLOAT32) {
+            uint8_t size = initial == CBOR_FLOAT64 ? 8 : 4;
+            if (offset + 1 + size > length) return false;
+            uint64_t bits = 0;
+            for (uint8_t i = 1; i <= size; i++) bits = (bits << 8) | data[offset + i];
+            if (size == 8) {
+                double number;
+                memcpy(&number, &bits, sizeof(number));
+                doc[key] = number;
+            } else {
+                uint32_t bits32 = (uint32_t)bits;
+                float number;
+                memcpy(&number, &bits32, sizeof(number));
+                doc[key] = number;
+            }
+            offset += 1 + size;
+        } else {
+            if (!readHead(data, length, &offset, &major, &argument)) return false;
+
+            if (major == CBOR_MAJOR_TEXT) {
+                if (offset + argument > length) return false;
+                doc[key] = String((const char*)&data[offset], argument);
+                offset += argument;
+            } else if (major == CBOR_MAJOR_UNSIGNED) {
+                // sm_id stays a string so tags look the same as JSON tags to the rest of the code
+                if (key == "sm_id") doc[key] = String((uint32_t)argument);
+                else doc[key] = (unsigned long long)argument;
+            } else if (major == CBOR_MAJOR_NEGATIVE) {
+                doc[key] = -1 - (long long)argument;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool spoolCborSpoolId(const uint8_t* data, size_t length, uint32_t* smId) {
+    if (length < SPOOL_CBOR_SM_ID_OFFSET + 4) return false;
+    if ((data[0] & 0xE0) != CBOR_MAJOR_MAP || data[1] != 0x00 || data[2] != (CBOR_MAJOR_UNSIGNED | 26)) return false;
+
+    *smId = ((uint32_t)data[3] << 24) | ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 8) | data[6];
+    return true;
+}
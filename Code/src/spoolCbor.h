@@ -0,0 +1,25 @@
+#ifndef SPOOLCBOR_H
+#define SPOOLCBOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Compact binary spool payload: a CBOR map with integer keys. sm_id is always the first
+// entry and encoded as a 32 bit unsigned integer, so it sits at a fixed payload offset.
+//
+//   A<n> 00 1A <sm_id big endian, 4 bytes> <key> <value> ...
+
+#define SPOOL_CBOR_SM_ID_OFFSET     3
+#define SPOOL_CBOR_MAX_ENTRIES      23      // Map header has to stay a single byte
+
+// Encodes a flat JSON object. Returns the encoded size or 0 if the object cannot be
+// represented (nested values, too many entries, buffer too small).
+size_t spoolCborEncode(JsonObjectConst object, uint8_t* buffer, size_t bufferSize);
+
+// Decodes a payload written by spoolCborEncode into doc (sm_id as string like in the JSON format).
+bool spoolCborDecode(const uint8_t* data, size_t length, JsonDocument& doc);
+
+// Reads sm_id from the fixed offset, works on the first bytes of a partially read payload.
+bool spoolCborSpoolId(const uint8_t* data, size_t length, uint32_t* smId);
+
+#endif
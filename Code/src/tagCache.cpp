@@ -0,0 +1,212 @@
+#include "tagCache.h"
+#include "ndef.h"
+#include <LittleFS.h>
+
+#define TAG_CACHE_MAGIC             0x54434335UL  // "TCC5", bump when TagCacheEntry changes
+
+// Only used by the NFC task
+static TagCacheEntry cacheEntries[TAG_CACHE_SIZE];
+static uint16_t cacheCount = 0;
+static uint32_t cacheUseCounter = 0;
+static bool cacheDirty = false;
+static unsigned long cacheChangedAt = 0;
+
+uint32_t tagCacheCrc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static int findEntry(const uint8_t* uid, uint8_t uidLength) {
+    for (uint16_t i = 0; i < cacheCount; i++) {
+        if (cacheEntries[i].uidLength == uidLength && memcmp(cacheEntries[i].uid, uid, uidLength) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void markDirty() {
+    cacheDirty = true;
+    cacheChangedAt = millis();
+}
+
+void tagCacheBegin() {
+    cacheCount = 0;
+    cacheUseCounter = 0;
+
+    File file = LittleFS.open(TAG_CACHE_FILE, "r");
+    if (!file) {
+        Serial.println("Tag-Cache: Keine gespeicherten Einträge");
+        return;
+    }
+
+    uint32_t magic = 0;
+    uint16_t count = 0;
+    if (file.read((uint8_t*)&magic, sizeof(magic)) != sizeof(magic) || magic != TAG_CACHE_MAGIC ||
+        file.read((uint8_t*)&count, sizeof(count)) != sizeof(count) || count > TAG_CACHE_SIZE) {
+        Serial.println("Tag-Cache: Datei ungültig, wird verworfen");
+        file.close();
+        LittleFS.remove(TAG_CACHE_FILE);
+        return;
+    }
+
+    size_t bytes = count * sizeof(TagCacheEntry);
+    if (file.read((uint8_t*)cacheEntries, bytes) != bytes) {
+        Serial.println("Tag-Cache: Datei unvollständig, wird verworfen");
+        file.close();
+        LittleFS.remove(TAG_CACHE_FILE);
+        return;
+    }
+    file.close();
+
+    cacheCount = count;
+    for (uint16_t i = 0; i < cacheCount; i++) {
+        if (cacheEntries[i].lastUsed > cacheUseCounter) cacheUseCounter = cacheEntries[i].lastUsed;
+    }
+
+    Serial.print("Tag-Cache: ");
+    Serial.print(cacheCount);
+    Serial.println(" Einträge geladen");
+}
+
+bool tagCacheLookup(const uint8_t* uid, uint8_t uidLength, TagCacheEntry* entry) {
+    int index = findEntry(uid, uidLength);
+    if (index < 0) return false;
+
+    // LRU order only lives in RAM, it is persisted with the next content change
+    cacheEntries[index].lastUsed = ++cacheUseCounter;
+    *entry = cacheEntries[index];
+    return true;
+}
+
+void tagCacheStore(const uint8_t* uid, uint8_t uidLength, const char* json, size_t jsonLength, uint32_t payloadCrc) {
+    if (uidLength > sizeof(cacheEntries[0].uid)) return;
+
+    // Without a checksum on the tag a cached entry could not be validated on the next read
+    if (payloadCrc == 0) {
+        tagCacheInvalidate(uid, uidLength);
+        return;
+    }
+
+    // Spool and location tags are cached, brand filament tags always need the full processing
+    const char* value;
+    size_t valueLength;
+    uint32_t smId = jsonFindValue(json, jsonLength, "sm_id", &value, &valueLength) ? jsonValueToUint(value, valueLength) : 0;
+    const char* location = NULL;
+    size_t locationLength = 0;
+    if (smId == 0 && (!jsonFindValue(json, jsonLength, "location", &location, &locationLength) || locationLength == 0)) {
+        tagCacheInvalidate(uid, uidLength);
+        return;
+    }
+
+    int index = findEntry(uid, uidLength);
+
+    if (index >= 0 && cacheEntries[index].smId == smId && cacheEntries[index].payloadCrc == payloadCrc) {
+        cacheEntries[index].lastUsed = ++cacheUseCounter;
+        return;
+    }
+
+    if (index < 0) {
+        if (cacheCount < TAG_CACHE_SIZE) {
+            index = cacheCount++;
+        } else {
+            // Evict the least recently used entry
+            index = 0;
+            for (uint16_t i = 1; i < cacheCount; i++) {
+                if (cacheEntries[i].lastUsed < cacheEntries[index].lastUsed) index = i;
+            }
+        }
+    }
+
+    TagCacheEntry& entry = cacheEntries[index];
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.uid, uid, uidLength);
+    entry.uidLength = uidLength;
+    entry.smId = smId;
+    entry.payloadCrc = payloadCrc;
+    entry.lastUsed = ++cacheUseCounter;
+    // Text is kept unescaped, like ArduinoJson hands it out on a full read
+    if (smId == 0) {
+        jsonCopyValue(entry.location, sizeof(entry.location), location, locationLength);
+    } else {
+        if (jsonFindValue(json, jsonLength, "brand", &value, &valueLength)) {
+            jsonCopyValue(entry.spool.brand, sizeof(entry.spool.brand), value, valueLength);
+        }
+        if (jsonFindValue(json, jsonLength, "type", &value, &valueLength)) {
+            jsonCopyValue(entry.spool.type, sizeof(entry.spool.type), value, valueLength);
+        }
+        if (jsonFindValue(json, jsonLength, "color_hex", &value, &valueLength)) {
+            jsonCopyValue(entry.spool.colorHex, sizeof(entry.spool.colorHex), value, valueLength);
+        }
+    }
+
+    markDirty();
+}
+
+void tagCacheInvalidate(const uint8_t* uid, uint8_t uidLength) {
+    int index = findEntry(uid, uidLength);
+    if (index < 0) return;
+
+    cacheEntries[index] = cacheEntries[--cacheCount];
+    markDirty();
+}
+
+void tagCacheFlush(bool force) {
+    if (!cacheDirty) return;
+    if (!force && millis() - cacheChangedAt < TAG_CACHE_FLUSH_DELAY) return;
+
+    File file = LittleFS.open(TAG_CACHE_FILE, "w");
+    if (!file) {
+        Serial.println("Tag-Cache: Fehler beim Öffnen der Datei zum Schreiben");
+        return;
+    }
+
+    uint32_t magic = TAG_CACHE_MAGIC;
+    file.write((const uint8_t*)&magic, sizeof(magic));
+    file.write((const uint8_t*)&cacheCount, sizeof(cacheCount));
+    file.write((const uint8_t*)cacheEntries, cacheCount * sizeof(TagCacheEntry));
+    file.close();
+
+    cacheDirty = false;
+    Serial.print("Tag-Cache: ");
+    Serial.print(cacheCount);
+    Serial.println(" Einträge gespeichert");
+}
+
+// Appends ,"key":"text" (without the comma for the first field) like snprintf, length keeps counting
+// when json is full
+static size_t appendJsonString(char* json, size_t size, size_t length, const char* key, const char* text) {
+    if (length < size) {
+        snprintf(json + length, size - length, "%s\"%s\":\"", length > 1 ? "," : "", key);
+    }
+    length += (length > 1 ? 1 : 0) + strlen(key) + 4;
+    length += jsonEscapeValue(length < size ? json + length : NULL, length < size ? size - length : 0, text);
+    if (length < size) json[length] = '"';
+    return length + 1;
+}
+
+size_t tagCacheToJson(const TagCacheEntry* entry, char* json, size_t size) {
+    if (size < 2) return 0;
+    size_t length = 1;
+    json[0] = '{';
+    if (entry->smId == 0) {
+        length = appendJsonString(json, size, length, "location", entry->location);
+    } else {
+        char smId[11];
+        snprintf(smId, sizeof(smId), "%lu", (unsigned long)entry->smId);
+        length = appendJsonString(json, size, length, "sm_id", smId);
+        if (entry->spool.brand[0]) length = appendJsonString(json, size, length, "brand", entry->spool.brand);
+        if (entry->spool.type[0]) length = appendJsonString(json, size, length, "type", entry->spool.type);
+        if (entry->spool.colorHex[0]) length = appendJsonString(json, size, length, "color_hex", entry->spool.colorHex);
+    }
+    if (length + 1 >= size) return 0;
+    json[length++] = '}';
+    json[length] = '\0';
+    return length;
+}
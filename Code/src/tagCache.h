@@ -0,0 +1,37 @@
+#ifndef TAGCACHE_H
+#define TAGCACHE_H
+
+#include <Arduino.h>
+
+#define TAG_CACHE_SIZE              300
+#define TAG_CACHE_FILE              "/tagcache.bin"
+#define TAG_CACHE_FLUSH_DELAY       10000U  // Write-behind delay after the last change in ms
+
+// UID -> spool or location entry, holds everything the web interface shows for a spool tag
+typedef struct {
+    uint8_t uid[7];
+    uint8_t uidLength;
+    uint32_t smId;              // 0 for a location tag
+    uint32_t payloadCrc;        // Checksum the tag carries in front of its message
+    uint32_t lastUsed;
+    union {
+        struct {
+            char brand[24];
+            char type[16];
+            char colorHex[10];
+        } spool;
+        char location[50];
+    };                          // Plain text, tagCacheToJson escapes it again
+} TagCacheEntry;
+
+void tagCacheBegin();
+bool tagCacheLookup(const uint8_t* uid, uint8_t uidLength, TagCacheEntry* entry);
+// payloadCrc is the checksum TLV of the tag, a tag without one (0) is not cached
+void tagCacheStore(const uint8_t* uid, uint8_t uidLength, const char* json, size_t jsonLength, uint32_t payloadCrc);
+void tagCacheInvalidate(const uint8_t* uid, uint8_t uidLength);
+void tagCacheFlush(bool force);
+// Writes the JSON the web interface gets for the tag, returns its length or 0 if size is too small
+size_t tagCacheToJson(const TagCacheEntry* entry, char* json, size_t size);
+uint32_t tagCacheCrc32(const uint8_t* data, size_t length);
+
+#endif
@@ -0,0 +1,202 @@
+#include "tagStats.h"
+#include <ArduinoJson.h>
+
+typedef struct {
+    uint8_t uid[7];
+    uint8_t uidLength;
+    const char* typeName;       // Name of the tag capability, NULL until the type is known
+    uint32_t lastSeen;
+    uint32_t detections;
+    uint32_t detectionRetries;
+    TagReadStats read;
+} TagStatsEntry;
+
+typedef struct {
+    const char* name;
+    TagReadStats read;
+} TagTypeStats;
+
+// The fixed policy of the reader before it kept statistics
+static const TagRetryPolicy DEFAULT_POLICY = { 3, 25 };
+
+static TagStatsEntry statsEntries[TAG_STATS_SIZE];
+static uint8_t statsCount = 0;
+static uint32_t statsUseCounter = 0;
+static TagTypeStats typeStats[TAG_STATS_TYPE_SIZE];
+static uint8_t typeCount = 0;
+static uint32_t detections = 0;
+static uint32_t detectionRetries = 0;
+
+// Tag the NFC task is working with
+static TagStatsEntry* selectedEntry = NULL;
+static TagTypeStats* selectedType = NULL;
+
+static TagStatsEntry* findEntry(const uint8_t* uid, uint8_t uidLength, bool add) {
+    if (uidLength > sizeof(statsEntries[0].uid)) return NULL;
+
+    for (uint8_t i = 0; i < statsCount; i++) {
+        if (statsEntries[i].uidLength == uidLength && memcmp(statsEntries[i].uid, uid, uidLength) == 0) {
+            statsEntries[i].lastSeen = ++statsUseCounter;
+            return &statsEntries[i];
+        }
+    }
+    if (!add) return NULL;
+
+    uint8_t index = 0;
+    if (statsCount < TAG_STATS_SIZE) {
+        index = statsCount++;
+    } else {
+        // Replace the tag that was not seen for the longest time
+        for (uint8_t i = 1; i < statsCount; i++) {
+            if (statsEntries[i].lastSeen < statsEntries[index].lastSeen) index = i;
+        }
+    }
+
+    TagStatsEntry& entry = statsEntries[index];
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.uid, uid, uidLength);
+    entry.uidLength = uidLength;
+    entry.lastSeen = ++statsUseCounter;
+    return &entry;
+}
+
+static TagTypeStats* findType(const char* name, bool add) {
+    for (uint8_t i = 0; i < typeCount; i++) {
+        if (strcmp(typeStats[i].name, name) == 0) return &typeStats[i];
+    }
+    if (!add || typeCount >= TAG_STATS_TYPE_SIZE) return NULL;
+
+    TagTypeStats& type = typeStats[typeCount++];
+    memset(&type, 0, sizeof(type));
+    type.name = name;
+    return &type;
+}
+
+static void addRead(TagReadStats& stats, uint16_t pages, uint8_t retries, bool success, uint32_t micros) {
+    if (stats.reads >= TAG_STATS_WINDOW) {
+        stats.reads /= 2;
+        stats.pages /= 2;
+        stats.retries /= 2;
+        stats.failures /= 2;
+        stats.readMicros /= 2;
+    }
+
+    stats.reads++;
+    stats.retries += retries;
+    stats.readMicros += micros;
+    if (success) {
+        stats.pages += pages;
+    } else {
+        stats.failures++;
+    }
+}
+
+// Tags that never needed a retry get one immediate retry, marginal ones more attempts and longer pauses
+static TagRetryPolicy policyFor(const TagReadStats& stats) {
+    if (stats.retries == 0 && stats.failures == 0) return { 2, 0 };
+
+    uint32_t retryPercent = stats.retries * 100 / stats.reads;
+    if (retryPercent < 25) return { 3, 10 };
+    if (retryPercent < 100) return { 4, 25 };
+    return { 5, 50 };
+}
+
+static TagRetryPolicy choosePolicy(const TagStatsEntry* entry, const TagTypeStats* type) {
+    if (entry != NULL && entry->read.reads >= TAG_STATS_MIN_READS) return policyFor(entry->read);
+    // A new tag starts with the experience of its type
+    if (type != NULL && type->read.reads >= TAG_STATS_MIN_READS) return policyFor(type->read);
+    return DEFAULT_POLICY;
+}
+
+void tagStatsSelect(const uint8_t* uid, uint8_t uidLength, const char* typeName) {
+    selectedEntry = findEntry(uid, uidLength, true);
+    selectedType = typeName ? findType(typeName, true) : NULL;
+    if (selectedEntry != NULL && typeName != NULL) selectedEntry->typeName = typeName;
+}
+
+TagRetryPolicy tagStatsReadPolicy() {
+    return choosePolicy(selectedEntry, selectedType);
+}
+
+void tagStatsRecordRead(uint16_t pages, uint8_t retries, bool success, uint32_t micros) {
+    if (selectedEntry != NULL) addRead(selectedEntry->read, pages, retries, success, micros);
+    if (selectedType != NULL) addRead(selectedType->read, pages, retries, success, micros);
+}
+
+// Without a tag in the field every attempt misses, so only successful detections are counted
+TagRetryPolicy tagStatsDetectionPolicy() {
+    if (detections >= TAG_STATS_MIN_READS && detectionRetries == 0) return { 2, 0 };
+    return DEFAULT_POLICY;
+}
+
+void tagStatsRecordDetection(const uint8_t* uid, uint8_t uidLength, uint8_t retries) {
+    if (detections >= TAG_STATS_WINDOW) {
+        detections /= 2;
+        detectionRetries /= 2;
+    }
+    detections++;
+    detectionRetries += retries;
+
+    TagStatsEntry* entry = findEntry(uid, uidLength, true);
+    if (entry != NULL) {
+        entry->detections++;
+        entry->detectionRetries += retries;
+    }
+}
+
+uint16_t tagStatsRetryDelay(const TagRetryPolicy& policy, uint8_t retry) {
+    uint32_t delayMs = (uint32_t)policy.retryDelayMs << (retry > 0 ? retry - 1 : 0);
+    return min(delayMs, (uint32_t)TAG_STATS_MAX_RETRY_DELAY);
+}
+
+static void readStatsToJson(JsonObject object, const TagReadStats& stats) {
+    object["reads"] = stats.reads;
+    object["pages"] = stats.pages;
+    object["retries"] = stats.retries;
+    object["failures"] = stats.failures;
+    object["usPerPage"] = stats.pages > 0 ? stats.readMicros / stats.pages : 0;
+}
+
+static void policyToJson(JsonObject object, const TagRetryPolicy& policy) {
+    object["attempts"] = policy.attempts;
+    object["retryDelay"] = policy.retryDelayMs;
+}
+
+String tagStatsToJson() {
+    JsonDocument doc;
+
+    JsonObject detection = doc["detection"].to<JsonObject>();
+    detection["detections"] = detections;
+    detection["retries"] = detectionRetries;
+    policyToJson(detection, tagStatsDetectionPolicy());
+
+    JsonArray types = doc["types"].to<JsonArray>();
+    for (uint8_t i = 0; i < typeCount; i++) {
+        JsonObject type = types.add<JsonObject>();
+        type["type"] = typeStats[i].name;
+        readStatsToJson(type, typeStats[i].read);
+        policyToJson(type, choosePolicy(NULL, &typeStats[i]));
+    }
+
+    JsonArray tags = doc["tags"].to<JsonArray>();
+    for (uint8_t i = 0; i < statsCount; i++) {
+        const TagStatsEntry& entry = statsEntries[i];
+        String uidString = "";
+        for (uint8_t j = 0; j < entry.uidLength; j++) {
+            uidString += String(entry.uid[j], HEX);
+            if (j < entry.uidLength - 1) uidString += ":";
+        }
+
+        JsonObject tag = tags.add<JsonObject>();
+        tag["uid"] = uidString;
+        tag["type"] = entry.typeName ? entry.typeName : "";
+        tag["detections"] = entry.detections;
+        tag["detectionRetries"] = entry.detectionRetries;
+        readStatsToJson(tag, entry.read);
+        policyToJson(tag, choosePolicy(&entry, entry.typeName ? findType(entry.typeName, false) : NULL));
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
@@ -0,0 +1,37 @@
+#ifndef TAGSTATS_H
+#define TAGSTATS_H
+
+#include <Arduino.h>
+
+#define TAG_STATS_SIZE              32      // UIDs with own counters, the least recently seen one is replaced
+#define TAG_STATS_TYPE_SIZE         8
+#define TAG_STATS_WINDOW            64      // Counters are halved at this many reads, old behaviour fades out
+#define TAG_STATS_MIN_READS         4       // Reads before the counters decide the retry policy
+#define TAG_STATS_MAX_RETRY_DELAY   200U    // Upper bound of the doubled retry delay in ms
+
+// Read counters of one UID or tag type. A read is one page burst of the NFC task.
+typedef struct {
+    uint32_t reads;
+    uint32_t pages;
+    uint32_t retries;
+    uint32_t failures;          // Reads that failed after all attempts
+    uint32_t readMicros;        // Time of all reads including retries
+} TagReadStats;
+
+typedef struct {
+    uint8_t attempts;           // Tries including the first one
+    uint16_t retryDelayMs;      // Pause before the first retry, doubled for each further one
+} TagRetryPolicy;
+
+// Only called by the NFC task
+void tagStatsSelect(const uint8_t* uid, uint8_t uidLength, const char* typeName);
+TagRetryPolicy tagStatsReadPolicy();
+void tagStatsRecordRead(uint16_t pages, uint8_t retries, bool success, uint32_t micros);
+TagRetryPolicy tagStatsDetectionPolicy();
+void tagStatsRecordDetection(const uint8_t* uid, uint8_t uidLength, uint8_t retries);
+uint16_t tagStatsRetryDelay(const TagRetryPolicy& policy, uint8_t retry);
+
+// Read by the web server without locking, values can be one read behind
+String tagStatsToJson();
+
+#endif
@@ -8,10 +8,13 @@
 #include "scale.h"
 #include "esp_task_wdt.h"
 #include <Update.h>
+#include <map>
 #include "display.h"
 #include "ota.h"
 #include "config.h"
 #include "debug.h"
+#include "tagStats.h"
+#include "nfcLatency.h"
 
 
 #ifndef VERSION
@@ -26,6 +29,27 @@ AsyncWebSocket ws("/ws");
 
 uint8_t lastSuccess = 0;
 nfcReaderStateType lastnfcReaderState = NFC_IDLE;
+volatile nfcReaderStateType websiteNfcState = NFC_IDLE; // Last state reported by the NFC task
+
+// NFC event as the web clients get it. The NFC task only queues it, websiteNfcTask builds and sends the messages.
+struct WebsiteNfcEvent {
+    nfcEventType type;
+    nfcReaderStateType state;
+    bool success;
+    uint16_t batchWritten;
+    uint16_t batchTotal;
+    char uid[NFC_UID_STRING_SIZE];
+};
+
+static QueueHandle_t websiteNfcQueue = NULL;
+
+// JSON of the last tag read, copied from the event. nfcJsonData itself belongs to the NFC task,
+// which clears or rebuilds it while the messages are still waiting to be sent.
+static char websiteNfcJson[NFC_JSON_DATA_SIZE] = "";
+static SemaphoreHandle_t websiteNfcJsonMutex = NULL;
+
+// Messages that arrive in several parts, kept per client so parts of two clients sending at once do not mix
+static std::map<uint32_t, String> wsPartialMessages;
 
 
 void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
@@ -43,11 +67,33 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
         Serial.println("Currently connected number of clients: " + String((*server).getClients().size()));
     } else if (type == WS_EVT_DISCONNECT) {
         Serial.println("Client getrennt.");
+        wsPartialMessages.erase(client->id());
     } else if (type == WS_EVT_ERROR) {
         Serial.printf("WebSocket Client #%u error(%u): %s\n", client->id(), *((uint16_t*)arg), (char*)data);
     } else if (type == WS_EVT_PONG) {
         Serial.printf("WebSocket Client #%u pong\n", client->id());
     } else if (type == WS_EVT_DATA) {
+        // Larger messages (e.g. batch writes) arrive in several parts
+        AwsFrameInfo *info = (AwsFrameInfo*)arg;
+        String wsMessage;
+        if (info->index > 0 || info->len != len) {
+            String& partial = wsPartialMessages[client->id()];
+            if (info->index == 0) {
+                partial = "";
+                partial.reserve(info->len);
+            } else if (partial.length() != info->index) {
+                Serial.printf("WebSocket Client #%u: Nachrichtenteil ohne Anfang verworfen\n", client->id());
+                wsPartialMessages.erase(client->id());
+                return;
+            }
+            partial.concat((const char*)data, len);
+            if (info->index + len < info->len) return;
+            wsMessage = std::move(partial);
+            wsPartialMessages.erase(client->id());
+            data = (uint8_t*)wsMessage.c_str();
+            len = wsMessage.length();
+        }
+
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, (char*)data, len);
         //String message = String((char*)data);
@@ -74,7 +120,20 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
                 String payloadString;
                 serializeJson(doc["payload"], payloadString);
 
-                startWriteJsonToTag((doc["tagType"] == "spool") ? true : false, payloadString.c_str());
+                startWriteJsonToTag((doc["tagType"] == "spool") ? true : false, payloadString.c_str(),
+                                    (doc["format"] == "cbor") ? NFC_FORMAT_CBOR : NFC_FORMAT_JSON);
+            }
+        }
+
+        else if (doc["type"] == "writeNfcBatch") {
+            if (doc["action"] == "cancel") {
+                stopBatchWrite();
+            } else if (doc["payloads"].is<JsonArray>()) {
+                // Jeder neu aufgelegte Tag bekommt den nächsten Payload
+                if (!startBatchWrite((doc["tagType"] == "spool") ? true : false, doc["payloads"].as<JsonArrayConst>(),
+                                     (doc["format"] == "cbor") ? NFC_FORMAT_CBOR : NFC_FORMAT_JSON)) {
+                    ws.textAll("{\"type\":\"writeNfcBatch\",\"state\":\"rejected\",\"max\":" + String(NFC_BATCH_MAX_TAGS) + "}");
+                }
             }
         }
 
@@ -150,10 +209,31 @@ String loadHtmlWithHeader(const char* filename) {
 
 void sendWriteResult(AsyncWebSocketClient *client, uint8_t success) {
     // Sende Erfolg/Misserfolg an alle Clients
-    String response = "{\"type\":\"writeNfcTag\",\"success\":" + String(success ? "1" : "0") + "}";
+    String response = "{\"type\":\"writeNfcTag\",\"success\":" + String(success ? "1" : "0") +
+                      ",\"pagesWritten\":" + String(nfcPagesWritten) + ",\"pagesSkipped\":" + String(nfcPagesSkipped) + "}";
+    ws.textAll(response);
+}
+
+// Progress of a batch write, one message per tag and one when the batch ends
+static void sendBatchProgress(const WebsiteNfcEvent& event) {
+    String response = "{\"type\":\"writeNfcBatch\",\"written\":" + String(event.batchWritten) +
+                      ",\"total\":" + String(event.batchTotal);
+    if (event.type == NFC_EVENT_BATCH_DONE) {
+        response += ",\"state\":\"" + String(event.success ? "done" : "cancelled") + "\"}";
+    } else {
+        response += ",\"state\":\"progress\",\"success\":" + String(event.success ? "1" : "0") +
+                    ",\"uid\":\"" + String(event.uid) + "\"}";
+    }
     ws.textAll(response);
 }
 
+// Spool details from Spoolman, sent once the prefetch of a read spool is done
+void sendSpoolInfo(int spoolId, const JsonDocument& info) {
+    String payload;
+    serializeJson(info, payload);
+    ws.textAll("{\"type\":\"spoolInfo\",\"sm_id\":\"" + String(spoolId) + "\",\"payload\":" + payload + "}");
+}
+
 void foundNfcTag(AsyncWebSocketClient *client, uint8_t success) {
     if (success == lastSuccess) return;
     ws.textAll("{\"type\":\"nfcTag\", \"payload\":{\"found\": " + String(success) + "}}");
@@ -162,15 +242,25 @@ void foundNfcTag(AsyncWebSocketClient *client, uint8_t success) {
 }
 
 void sendNfcData() {
-    if (lastnfcReaderState == nfcReaderState) return;
+    nfcReaderStateType state = websiteNfcState;
+    if (lastnfcReaderState == state) return;
     // TBD: Why is there no status for reading the tag?
-    switch(nfcReaderState){
+    switch(state){
         case NFC_IDLE:
             ws.textAll("{\"type\":\"nfcData\", \"payload\":{}}");
             break;
-        case NFC_READ_SUCCESS:
-            ws.textAll("{\"type\":\"nfcData\", \"payload\":" + nfcJsonData + "}");
+        case NFC_READ_SUCCESS: {
+            // Reserved up front, so the lock is only held for the copy
+            String message;
+            message.reserve(NFC_JSON_DATA_SIZE + 32);
+            message = "{\"type\":\"nfcData\", \"payload\":";
+            xSemaphoreTake(websiteNfcJsonMutex, portMAX_DELAY);
+            message += websiteNfcJson;
+            xSemaphoreGive(websiteNfcJsonMutex);
+            message += "}";
+            ws.textAll(message);
             break;
+        }
         case NFC_READ_ERROR:
             ws.textAll("{\"type\":\"nfcData\", \"payload\":{\"error\":\"Empty Tag or Data not readable\"}}");
             break;
@@ -186,7 +276,61 @@ void sendNfcData() {
         case DEFAULT:
             ws.textAll("{\"type\":\"nfcData\", \"payload\":{\"error\":\"Something went wrong\"}}");
     }
-    lastnfcReaderState = nfcReaderState;
+    lastnfcReaderState = state;
+}
+
+static void onNfcEvent(const NfcEvent& event) {
+    if (event.reader != NFC_SCALE_READER) return; // The page shows the scale reader only
+
+    WebsiteNfcEvent update;
+    update.type = event.type;
+    update.state = event.state;
+    update.success = event.success;
+    update.batchWritten = event.batchWritten;
+    update.batchTotal = event.batchTotal;
+    strlcpy(update.uid, event.uid, sizeof(update.uid));
+    if (event.type == NFC_EVENT_READ_DONE && websiteNfcJsonMutex != NULL) {
+        xSemaphoreTake(websiteNfcJsonMutex, portMAX_DELAY);
+        strlcpy(websiteNfcJson, event.payload != nullptr ? event.payload : "", sizeof(websiteNfcJson));
+        xSemaphoreGive(websiteNfcJsonMutex);
+    }
+    if (websiteNfcQueue == NULL || xQueueSend(websiteNfcQueue, &update, 0) != pdTRUE) {
+        Serial.println("Fehler: Warteschlange für NFC-Events der Website ist voll.");
+    }
+}
+
+// Sends the queued NFC events to the web clients
+static void websiteNfcTask(void *parameter) {
+    WebsiteNfcEvent event;
+
+    while (true) {
+        xQueueReceive(websiteNfcQueue, &event, portMAX_DELAY);
+        websiteNfcState = event.state;
+
+        switch (event.type) {
+            case NFC_EVENT_TAG_ARRIVED:
+                foundNfcTag(nullptr, 1);
+                break;
+            case NFC_EVENT_TAG_REMOVED:
+                foundNfcTag(nullptr, 0);
+                break;
+            case NFC_EVENT_WRITE_DONE:
+                if (event.batchTotal > 0) {
+                    sendBatchProgress(event);
+                } else {
+                    sendWriteResult(nullptr, event.success);
+                }
+                break;
+            case NFC_EVENT_BATCH_DONE:
+                sendBatchProgress(event);
+                break;
+            default:
+                break;
+        }
+
+        // aktualisieren der Website wenn sich der Status ändert
+        sendNfcData();
+    }
 }
 
 void sendAmsData(AsyncWebSocketClient *client) {
@@ -197,6 +341,13 @@ void sendAmsData(AsyncWebSocketClient *client) {
 
 void setupWebserver(AsyncWebServer &server) {
     oledShowProgressBar(2, 7, DISPLAY_BOOT_TEXT, "Webserver init");
+    websiteNfcJsonMutex = xSemaphoreCreateMutex();
+    websiteNfcQueue = xQueueCreate(WEBSITE_NFC_QUEUE_SIZE, sizeof(WebsiteNfcEvent));
+    if (websiteNfcJsonMutex == NULL || websiteNfcQueue == NULL ||
+        xTaskCreate(websiteNfcTask, "WebsiteNfc", 4096, NULL, 0, NULL) != pdPASS) {
+        Serial.println("Fehler beim Erstellen des Website-NFC-Tasks");
+    }
+    nfcSubscribe(onNfcEvent);
     // Deaktiviere alle Debug-Ausgaben
     Serial.setDebugOutput(false);
     
@@ -442,6 +593,21 @@ void setupWebserver(AsyncWebServer &server) {
         request->send(200, "application/json", jsonResponse);
     });
 
+    // Lese-Statistik und Retry-Policy der NFC-Tags
+    server.on("/api/nfc/stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(200, "application/json", tagStatsToJson());
+    });
+
+    // Latenz-Histogramme der NFC-Phasen, DELETE setzt sie zurück
+    server.on("/api/nfc/latency", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(200, "application/json", nfcLatencyToJson());
+    });
+
+    server.on("/api/nfc/latency", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        nfcLatencyReset();
+        request->send(200, "application/json", "{\"success\": true}");
+    });
+
     // Fehlerbehandlung für nicht gefundene Seiten
     server.onNotFound([](AsyncWebServerRequest *request){
         Serial.print("404 - Nicht gefunden: ");
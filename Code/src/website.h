@@ -27,5 +27,6 @@ void sendAmsData(AsyncWebSocketClient *client);
 void sendNfcData();
 void foundNfcTag(AsyncWebSocketClient *client, uint8_t success);
 void sendWriteResult(AsyncWebSocketClient *client, uint8_t success);
+void sendSpoolInfo(int spoolId, const JsonDocument& info);
 
 #endif